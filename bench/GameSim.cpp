@@ -0,0 +1,895 @@
+/**********************************************************************************
+ *
+ *	GameSim  --  deterministic whole-game simulator for the Scoreboard firmware
+ *
+ *  File:          GameSim.cpp
+ *
+ *  Function:      Runs the unmodified setup()/loop() from Scoreboard.cpp on the
+ *                 NativeShims virtual clock and plays games against it: button
+ *                 gestures (with contact bounce), ball passes sampled at the
+ *                 sensor's own rate, range glitches, bus faults and hangs,
+ *                 and a warm reset mid-round.  Only the
+ *                 outputs are judged - the digits and brightness in the MAX7219
+ *                 registers, the buzzer pitch, power-downs and the gaps between
+ *                 watchdog kicks - with invariants checked after every step.
+ *                 Display effects are
+ *                 allowed only where they belong: the score blinking just after
+ *                 a basket, "HI" scrolling just after a round, the brightness
+ *                 pulsing in the last seconds and fading before power-down.
+ *
+ *                 Scripted scenarios run first, then seeded random games.  The
+ *                 clock starts just short of the micros() and millis() wraps so
+ *                 both roll over during the scripts.  Any failure names the
+ *                 seed and game; the same arguments replay it exactly.
+ *
+ *                 Time moves a millisecond a step, two loop() passes, only
+ *                 around something happening: a button gesture, a sample, a
+ *                 bus transfer or fault, the clock or the idle timeout running
+ *                 out.  Between those loop() is not called and the clock jumps
+ *                 to the next of them, at most SKIP_MAX_MS at a time, as a
+ *                 slow loop() would see it; the scheduler counts those jumps
+ *                 as late tasks, so its statistics mean nothing here.
+ *
+ *                   pio run -e native_sim -t exec -a "[-n games] [-s seed] [-v]"
+ *
+ *                   -n games   random games after the scripts (default 1000)
+ *                   -s seed    random game seed (default 1)
+ *                   -v         echo the firmware's serial output
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include "Arduino.h"
+#include "NativeHost.h"
+#include "Config.h"
+#include "Display.h"
+#include "Buzzer.h"
+#include "Sensor.h"
+#include "GameClock.h"
+#include "GameMode.h"
+#include "Scheduler.h"
+#include "Recovery.h"
+#include "TwiQueue.h"
+#include "DFRobot_VL6180X.h"
+
+//	Scoreboard.cpp entry points and the state the checks compare against
+void	setup();
+void	loop();
+extern GameRound game[Lanes];
+extern bool shooting;
+extern DFRobot_VL6180X VL6180X[Lanes];
+
+static_assert(Lanes == 1, "GameSim judges a single lane; see LaneBench for several");
+
+#define US_PER_MS		1000ULL
+#define LOOP_STEP_US	500			// two loop() passes per simulated millisecond
+#define BALL_RANGE		60			// mm seen while the ball is in the hoop
+#define EMPTY_RANGE		180			// mm seen across the empty hoop
+#define GLITCH_RANGE	100			// single-sample dip below the threshold
+#define ERR_STATUS		11			// VL6180X no-target error
+#define FRAME_SLACK_MS	(FrameInterval + 5)		// display may lag a change by a frame
+#define MICROS_WRAP_MS	20000ULL	// micros() wraps this far into the run
+#define MILLIS_WRAP_MS	200000ULL	// ...and millis() here
+#define HIGH_SCROLL_MS	(ScrollMs(2) + FRAME_SLACK_MS)	// "HI" after a round
+#define SKIP_MAX_MS		FlashPhaseMs	// longest jump: every blink of a flash, and every note, is seen
+
+typedef unsigned long long SimTime;	// us since boot; never wraps, unlike the firmware clock
+
+struct Ball {
+	SimTime		entry, exit;
+};
+
+struct Edge {
+	SimTime		at;
+	byte		level;
+};
+
+//	What the simulator puts in front of the firmware
+struct World {
+	SimTime				now;
+	std::vector<Ball>	balls;			// in entry order
+	size_t				ballHead;		// first ball not yet gone by
+	std::vector<Edge>	edges;			// pending button edges, in time order
+	SimTime				lastEdge;
+	SimTime				nextSample;
+	SimTime				faultUntil;		// bus NACKs everything before this
+	unsigned int		glitchPct;		// per-sample chance of a dip, in 0.1%
+	unsigned int		errorPct;		// per-sample chance of an error status, in 0.1%
+	unsigned long		glitches;		// dips below the threshold since shooting began
+};
+
+//	What the firmware showed, and the history the invariants need
+struct Seen {
+	bool			shooting, clockRun, held, highShown;
+	byte			mode, pitch, level;
+	int				baskets, score, clockTenths;
+	char			scoreText[4], clockText[5];
+	unsigned long	powerDowns, beeps, melodies, rounds, cancels;
+	SimTime			shootStart, lastBasket, scoreChange, quietSince, roundEnd;
+};
+
+static World world;
+static Seen seen;
+static const char *scenario = "boot";
+static unsigned long game_ = 0;
+static unsigned long failures = 0;
+static SimTime failedAt = ~0ULL;
+
+static void fail(const char *fmt, ...) {
+	va_list ap;
+
+	failures++;
+	if (failures > 20) return;					// the first few say enough
+	fprintf(stderr, "FAIL %s", scenario);
+	if (game_) fprintf(stderr, " game %lu", game_);
+	fprintf(stderr, " at %.3f s: ", world.now / 1e6);
+	va_start(ap, fmt);
+	vfprintf(stderr, fmt, ap);
+	va_end(ap);
+	fprintf(stderr, "  [score %s clock %s]\n", seen.scoreText, seen.clockText);
+	if (failedAt == ~0ULL) failedAt = world.now;
+}
+
+//	Display: decode the MAX7219 digit registers back to characters
+
+static char glyph(byte segs) {
+	static const byte digits[10] = { 0x7E, 0x30, 0x6D, 0x79, 0x33, 0x5B, 0x5F, 0x70, 0x7F, 0x7B };
+	segs &= 0x7F;
+	for (byte i = 0; i < 10; i++)
+		if (digits[i] == segs) return '0' + i;
+	if (segs == 0x4F) return 'E';
+	if (segs == 0x67) return 'P';
+	if (segs == 0x37) return 'H';
+	if (segs == 0x06) return 'I';
+	if (segs == 0) return ' ';
+	return '?';
+}
+
+//	Digits 0,1 are score units and tens, 2,3 clock units and tens (registers 1-4)
+static void readDisplay() {
+	const byte *r = native::max7219(0);
+	char *c = seen.clockText;
+
+	seen.scoreText[0] = glyph(r[2]);
+	seen.scoreText[1] = glyph(r[1]);
+	seen.scoreText[2] = 0;
+	seen.level = r[10];
+	*c++ = glyph(r[4]);
+	if (r[4] & 0x80) *c++ = '.';
+	*c++ = glyph(r[3]);
+	*c = 0;
+
+	const char *t = seen.clockText;
+	if (t[1] == '.') seen.clockTenths = (t[0] - '0') * 10 + (t[2] - '0');
+	else if (t[0] >= '0' && t[0] <= '9' && t[1] >= '0' && t[1] <= '9')
+		seen.clockTenths = ((t[0] - '0') * 10 + (t[1] - '0')) * 10;
+	else seen.clockTenths = -1;
+}
+
+static int shownScore() {
+	const char *t = seen.scoreText;
+	return (t[0] - '0') * 10 + (t[1] - '0');
+}
+
+//	Stimulus
+
+static void edge(SimTime at, byte level) {
+	Edge e = { at, level };
+	world.edges.insert(std::upper_bound(world.edges.begin(), world.edges.end(), e,
+		[](const Edge &a, const Edge &b) { return a.at < b.at; }), e);
+}
+
+//	Press and release, starting delayMs from now, with optional contact bounce
+static void press(unsigned long holdMs, unsigned long delayMs = 0, bool bounce = false) {
+	SimTime down = world.now + delayMs * US_PER_MS, up = down + holdMs * US_PER_MS;
+	edge(down, LOW);
+	edge(up, HIGH);
+	if (bounce) {
+		for (int i = 1; i <= 4; i++) {
+			edge(down + i * 300, i & 1 ? HIGH : LOW);
+			edge(up + i * 300, i & 1 ? LOW : HIGH);
+		}
+	}
+}
+
+static void shortPress(unsigned long delayMs = 0)	{ press(100, delayMs); }
+static void longPress(unsigned long delayMs = 0)	{ press(Config.longPressMs + 200, delayMs); }
+
+static void doublePress(unsigned long delayMs = 0) {
+	press(80, delayMs);
+	press(80, delayMs + 80 + Config.doubleGapMs / 2);
+}
+
+static SimTime samplePeriod() {
+	return VL6180X[0].periodMs_ * US_PER_MS;
+}
+
+//	A ball entering at the sensor's first sample at or after t, so the window
+//	mode's one sample in 200 ms sees it exactly as the high-rate mode does
+static SimTime shootAt(SimTime t) {
+	SimTime p = samplePeriod(), s = world.nextSample;
+	if (t > s) s += (t - s + p - 1) / p * p;
+	Ball b = { s - 2000, s - 2000 + 60000 };
+	world.balls.push_back(b);
+	return s;
+}
+
+//	The last sample at or before t, to place a ball against the end of the clock
+static SimTime sampleBefore(SimTime t) {
+	SimTime p = samplePeriod(), s = world.nextSample;
+	return s + (t - s) / p * p;
+}
+
+static void ball(SimTime entry, unsigned long transitUs) {
+	Ball b = { entry, entry + transitUs };
+	world.balls.push_back(b);
+}
+
+static bool ballIn(SimTime t) {
+	size_t &i = world.ballHead;
+	while (i < world.balls.size() && world.balls[i].exit <= t && world.balls[i].entry <= t) i++;
+	for (size_t k = i; k < world.balls.size() && world.balls[k].entry <= t; k++)
+		if (t < world.balls[k].exit) return true;
+	return false;
+}
+
+//	Balls in view at some time after t and by now: what could have been counted
+static unsigned long ballsFrom(SimTime t) {
+	unsigned long n = 0;
+	for (size_t i = 0; i < world.balls.size(); i++)
+		if (world.balls[i].exit > t && world.balls[i].entry <= world.now) n++;
+	return n;
+}
+
+static void sensorSample() {
+	byte range = ballIn(world.now) ? BALL_RANGE : EMPTY_RANGE;
+	byte status = VL6180X_NO_ERR;
+	unsigned int roll = rand() % 1000;
+	static bool glitched = false;
+
+	if (glitched) roll = 1000;						// glitches are single samples
+	glitched = roll < world.glitchPct;
+	if (glitched) {
+		if (range == EMPTY_RANGE) world.glitches++;
+		range = GLITCH_RANGE;
+	} else if (roll < world.glitchPct + world.errorPct) {
+		range = 255;
+		status = ERR_STATUS;
+	}
+	VL6180X[0].status = status;
+	VL6180X[0].sample(range);
+}
+
+//	Invariants, checked once per simulated millisecond
+
+static void observe() {
+	SimTime now = world.now;
+	byte pitch = native::tonePitch();
+	bool held = native::pinLevel(Config.buttonPin) == LOW;
+	int prevTenths = seen.clockTenths;
+	static unsigned long spi = ~0UL;
+
+	if (native::bus.spi != spi) {					// digits change only with a write
+		spi = native::bus.spi;
+		readDisplay();
+	}
+
+	if (strchr(seen.clockText, '?'))
+		fail("clock digits \"%s\" not a known pattern\n", seen.clockText);
+	if (native::max7219(0)[12] != 1)
+		fail("display left shut down\n");
+	if (native::wdtLongestMs() >= WatchdogMs)
+		fail("watchdog went %lu ms without a kick\n", native::wdtLongestMs());
+
+	if (pitch != seen.pitch) {
+		if (pitch == Pitch(NOTE_BEEP)) seen.beeps++;
+		if (pitch == Pitch(NOTE_A5)) seen.melodies++;
+		seen.pitch = pitch;
+	}
+
+	//	Rounds start, end and change mode; each of these restarts the idle timeout
+	bool run = clockRunning();
+	if (run != seen.clockRun || shooting != seen.shooting || gameMode != seen.mode)
+		seen.quietSince = now;
+	if (shooting && !seen.shooting) {
+		seen.shootStart = now;
+		seen.lastBasket = now;
+		world.glitches = 0;
+		seen.rounds++;
+		if (game[0].baskets != 0) fail("round began with %d baskets\n", game[0].baskets);
+	}
+	if (!shooting && seen.shooting) {
+		if (pitch == Pitch(NOTE_E5)) seen.roundEnd = now;	// end of round melody
+		else if (seen.held) seen.cancels++;				// long press cancels without one
+		else fail("round ended without the time-up melody\n");
+	}
+	seen.clockRun = run;
+	seen.mode = gameMode;
+	seen.held = held;
+
+	//	Effects: a blank score just after a basket (the flash may reach the
+	//	digits in the millisecond it is counted), "HI" just after a round
+	bool flashing = game[0].baskets > seen.baskets
+		|| now - seen.lastBasket < (FlashMs + FRAME_SLACK_MS) * US_PER_MS;
+	bool scrolling = now - seen.roundEnd < HIGH_SCROLL_MS * US_PER_MS	// ...until a press starts a round
+		&& (!run || now - seen.quietSince < FRAME_SLACK_MS * US_PER_MS);
+	bool letters = strpbrk(seen.scoreText, "HI") || strpbrk(seen.clockText, "HI");
+	if (letters) {
+		if (!scrolling) fail("\"HI\" shown outside the end of a round\n");
+		seen.highShown = true;
+	}
+	bool blank = strcmp(seen.scoreText, "  ") == 0;
+	for (int d = 0; d < 2; d++)
+		if ((seen.scoreText[d] < '0' || seen.scoreText[d] > '9') && !(flashing && blank) && !scrolling)
+			fail("score digits \"%s\" not a number\n", seen.scoreText);
+
+	//	Baskets: only while shooting, each with a beep, never more than balls
+	if (game[0].baskets != seen.baskets) {
+		if (game[0].baskets > seen.baskets) {
+			if (!shooting && !seen.shooting) fail("basket counted while not shooting\n");
+			if (pitch != Pitch(NOTE_BEEP) && pitch != Pitch(NOTE_E5))
+				fail("basket %d without a beep\n", game[0].baskets);
+			unsigned long could = ballsFrom(seen.shootStart) + world.glitches;
+			if ((unsigned long)game[0].baskets > could)
+				fail("%d baskets from %lu balls\n", game[0].baskets, could);
+			seen.lastBasket = now;
+		}
+		seen.baskets = game[0].baskets;
+	}
+	if (game[0].score != seen.score) {
+		seen.score = game[0].score;
+		seen.scoreChange = now;
+	}
+	if (now - seen.scoreChange > FRAME_SLACK_MS * US_PER_MS && !flashing && !scrolling
+			&& shownScore() != game[0].score % 100)
+		fail("score shows %s for %d\n", seen.scoreText, game[0].score);
+
+	//	Shot clock: counts down while shooting, restarted only by a basket,
+	//	and the round ends on time for its mode
+	if (shooting) {
+		bool restarted = now - seen.lastBasket < FRAME_SLACK_MS * US_PER_MS;
+		if (seen.clockTenths >= 0 && prevTenths >= 0 && seen.clockTenths > prevTenths && !restarted)
+			fail("clock went up from %d to %d tenths\n", prevTenths, seen.clockTenths);
+		SimTime from = gameMode == MODE_RAPID ? seen.lastBasket : seen.shootStart;
+		if (now - from > (modeWindowMs() + 5) * US_PER_MS)
+			fail("still shooting %llu ms after the clock began\n", (now - from) / US_PER_MS);
+	}
+	seen.shooting = shooting;
+
+	//	Brightness: steady, but for the pulse in the last seconds and the
+	//	fade over the end of the idle timeout
+	SimTime quiet = now - seen.quietSince;
+	SimTime fadeFrom = (Config.idleTimeoutMs - Config.sleepFadeMs) * US_PER_MS;
+	if (shooting && clockRemaining() < Config.pulseBelowMs - FRAME_SLACK_MS) {
+		if (seen.level < PulseLow || seen.level > PulseHigh)
+			fail("intensity %u outside the pulse\n", seen.level);
+	} else if (quiet < fadeFrom && quiet > FRAME_SLACK_MS * US_PER_MS
+			&& (clockRemaining() > Config.pulseBelowMs + FRAME_SLACK_MS || !shooting)) {
+		if (seen.level != DisplayBright) fail("intensity %u, not the usual %u\n", seen.level, DisplayBright);
+	} else if (!run && native::powerDowns() == seen.powerDowns && quiet > fadeFrom + (Config.sleepFadeMs * 3 / 4) * US_PER_MS && seen.level > DisplayBright / 2) {
+		fail("intensity %u late in the fade\n", seen.level);
+	}
+
+	//	Power-down exactly one idle timeout after the last start, end or mode change
+	if (native::powerDowns() != seen.powerDowns) {
+		seen.powerDowns = native::powerDowns();
+		if (quiet < Config.idleTimeoutMs * US_PER_MS)
+			fail("powered down after only %llu ms idle\n", quiet / US_PER_MS);
+		seen.quietSince = now;							// the wake renews the timeout
+	} else if (!run && quiet > (Config.idleTimeoutMs + 5) * US_PER_MS) {
+		fail("no power-down after %llu ms idle\n", quiet / US_PER_MS);
+		seen.quietSince = now;
+	}
+}
+
+//	Time
+
+static void step() {
+	for (int half = 0; half < 2; half++) {
+		while (!world.edges.empty() && world.edges.front().at <= world.now) {
+			native::setPin(Config.buttonPin, world.edges.front().level);
+			native::raiseInterrupt(digitalPinToInterrupt(Config.buttonPin));
+			world.edges.erase(world.edges.begin());
+			world.lastEdge = world.now;
+		}
+		VL6180X[0].present = world.now >= world.faultUntil;
+		if (VL6180X[0].continuous && VL6180X[0].periodMs_) {
+			if (world.nextSample + samplePeriod() < world.now)
+				world.nextSample = world.now;			// ranging just started
+			while (world.nextSample <= world.now) {
+				sensorSample();
+				world.nextSample += samplePeriod();
+			}
+		}
+		loop();
+		native::advanceMicros(LOOP_STEP_US);
+		world.now += LOOP_STEP_US;
+	}
+	observe();
+}
+
+//	The firmware has nothing to act on before this: no edge, sample or end of
+//	a fault to deliver, no bus transfer under way, no button deadline (the
+//	bounce window closing, or a long press, which counts from the accepted
+//	edge up to a bounce window before the last one), and neither the clock
+//	nor the idle timeout about to run out
+static SimTime quietUntil() {
+	SimTime now = world.now, t = now + SKIP_MAX_MS * US_PER_MS;
+	SimTime since = now - world.lastEdge;
+
+	if (!twiIdle() || native::sdaHeld() || since < (Config.bounceMs + 2) * US_PER_MS)
+		return now;
+	if (native::pinLevel(Config.buttonPin) == LOW) {
+		SimTime from = (Config.longPressMs - Config.bounceMs) * US_PER_MS;
+		if (since < from) t = std::min(t, world.lastEdge + from);
+		else if (since < (Config.longPressMs + 2) * US_PER_MS) return now;
+	}
+	if (now < world.faultUntil) t = std::min(t, world.faultUntil);
+	if (!world.edges.empty()) t = std::min(t, world.edges.front().at);
+	if (VL6180X[0].continuous && VL6180X[0].periodMs_) t = std::min(t, world.nextSample);
+	if (clockRunning()) {
+		unsigned long left = clockRemaining();		// to the end, or to the end of the precount
+		if (!shooting && left > modeWindowMs()) left -= modeWindowMs();
+		t = std::min(t, now + left * US_PER_MS);
+	} else {
+		t = std::min(t, seen.quietSince + Config.idleTimeoutMs * US_PER_MS);
+	}
+	return t;
+}
+
+//	Jump the quiet whole milliseconds before the next step, up to limit
+static void skip(SimTime limit) {
+	SimTime t = std::min(quietUntil(), limit);
+	if (t <= world.now) return;
+	t -= (t - world.now) % US_PER_MS;				// steps stay on the millisecond
+	native::advanceMicros(t - world.now);
+	world.now = t;
+}
+
+static void runTo(SimTime end) {
+	while (world.now < end) {
+		skip(end - US_PER_MS);						// ending on a step, as before a hang
+		step();
+	}
+}
+
+static void runMs(unsigned long ms) {
+	runTo(world.now + ms * US_PER_MS);
+}
+
+static bool idle() {
+	return !shooting && !clockRunning() && !buzzerBusy() && world.edges.empty();
+}
+
+//	Run until the round and its melody are over; false if that takes too long
+static bool runUntilIdle(unsigned long maxMs) {
+	SimTime end = world.now + (50 + maxMs) * US_PER_MS;
+	runMs(50);
+	while (!idle()) {
+		if (world.now >= end) {
+			fail("round still going after the time allowed\n");
+			return false;
+		}
+		skip(end);
+		step();
+	}
+	return true;
+}
+
+static void expect(bool ok, const char *what) {
+	if (!ok) fail("expected %s\n", what);
+}
+
+static void expectScore(int n) {
+	if (shownScore() != n) fail("expected score %d\n", n);
+}
+
+static void expectClock(const char *text) {
+	if (strcmp(seen.clockText, text) != 0) fail("expected clock \"%s\"\n", text);
+}
+
+static void selectMode(byte mode) {
+	for (int i = 0; gameMode != mode && i < MODE_COUNT; i++) {
+		longPress();
+		runMs(Config.longPressMs + 300);
+	}
+	runMs(2100);									// let the "P<n>" display lapse
+	expect(gameMode == mode, "mode selected");
+}
+
+//	Start a round and run to the first millisecond of shooting
+static SimTime startRound() {
+	shortPress();
+	for (unsigned long ms = 0; !shooting && ms < Config.fullcountMs() + 500; ms++) step();
+	expect(shooting, "shooting after the precount");
+	return world.now;
+}
+
+//	Scripted scenarios
+
+//	Sensor missing at power-on: "E1", presses ignored, then found by the retries
+static void scriptBoot() {
+	runMs(300);
+	expectClock("E1");
+	shortPress();
+	runMs(300);
+	expect(!clockRunning(), "no round without a sensor");
+	world.faultUntil = 0;
+	VL6180X[0].present = true;
+	runMs(SensorRetryMax + 100);
+	expect(sensorReady(), "sensor found by the retries");
+	expectClock("00");
+	expectScore(0);
+}
+
+//	A timed round with micros() rolling over in the middle of it
+static void scriptMicrosWrap() {
+	selectMode(MODE_TIMED);
+	SimTime start = startRound();
+	expect(world.now < MICROS_WRAP_MS * US_PER_MS, "round under way before micros() wraps");
+	for (int i = 0; i < 20; i++)
+		shootAt(start + (500 + i * 1400ULL) * US_PER_MS);
+	seen.highShown = false;
+	runUntilIdle(40000);
+	expect(world.now > MICROS_WRAP_MS * US_PER_MS, "round spanned the wrap");
+	expectScore(20);
+	expect(seen.highShown, "\"HI\" for the first round's score");
+}
+
+//	Idle across the millis() rollover: the display must not time out early
+static void scriptMillisWrap() {
+	unsigned long downs = native::powerDowns();
+	expect(world.now < MILLIS_WRAP_MS * US_PER_MS, "idle begins before millis() wraps");
+	runMs(Config.idleTimeoutMs + 10);
+	expect(world.now > MILLIS_WRAP_MS * US_PER_MS, "idle spanned the wrap");
+	expect(native::powerDowns() == downs + 1, "one power-down");
+}
+
+//	A basket confirmed before the clock expires counts; one after does not
+static void scriptLastTick() {
+	selectMode(MODE_TIMED);
+	SimTime start = startRound();
+	SimTime end = start + Config.shotClockSecs * 1000ULL * US_PER_MS;
+	shootAt(sampleBefore(end - 30 * US_PER_MS));
+	shootAt(end + 30 * US_PER_MS);
+	runUntilIdle(Config.fullcountMs() + 5000);
+	expectScore(1);
+}
+
+//	The score blinks after a basket and the brightness beats through the last
+//	seconds; one basket is no high score after twenty, so no "HI"
+static void scriptEffects() {
+	selectMode(MODE_TIMED);
+	SimTime start = startRound();
+	shootAt(start + 2000 * US_PER_MS);
+	while (game[0].baskets == 0 && shooting) step();
+	runMs(FRAME_SLACK_MS);
+	expect(strcmp(seen.scoreText, "  ") == 0, "score blanked by the flash");
+	runMs(FlashMs);
+	expectScore(1);
+
+	while (shooting && clockRemaining() >= Config.pulseBelowMs) step();
+	byte lo = 15, hi = 0;
+	for (int ms = 0; ms < 1000; ms++) {
+		step();
+		lo = std::min(lo, seen.level);
+		hi = std::max(hi, seen.level);
+	}
+	expect(hi - lo >= (PulseHigh - PulseLow) / 2, "brightness pulsing in the last seconds");
+	seen.highShown = false;
+	runUntilIdle(Config.fullcountMs() + 5000);
+	expect(!seen.highShown, "no \"HI\" short of the high score");
+}
+
+//	A second press in the precount restarts it; a double press counts as one
+static void scriptPrecountPress() {
+	selectMode(MODE_TIMED);
+	unsigned long rounds = seen.rounds, melodies = seen.melodies;
+	shortPress();
+	runMs(2000);
+	expect(clockRunning() && !shooting, "in the precount");
+	doublePress();
+	runMs(1000);
+	expect(clockRemaining() > Config.fullcountMs() - 1500, "precount restarted");
+	runUntilIdle(Config.fullcountMs() + 5000);
+	expect(seen.rounds == rounds + 1, "exactly one round");
+	expect(seen.melodies == melodies + 1, "one time-up melody");
+	expectScore(0);
+}
+
+//	Long press while shooting cancels without the melody; the score stays up
+static void scriptCancel() {
+	selectMode(MODE_TIMED);
+	unsigned long melodies = seen.melodies, cancels = seen.cancels;
+	SimTime start = startRound();
+	shootAt(start + 1000 * US_PER_MS);
+	runMs(3000);
+	longPress();
+	runUntilIdle(5000);
+	expect(seen.cancels == cancels + 1, "round cancelled");
+	expect(seen.melodies == melodies, "no time-up melody");
+	expectScore(1);
+	expectClock("00");
+}
+
+//	Contact bounce on both edges still starts exactly one round
+static void scriptBounce() {
+	selectMode(MODE_TIMED);
+	unsigned long rounds = seen.rounds;
+	press(120, 0, true);
+	runUntilIdle(Config.fullcountMs() + 5000);
+	expect(seen.rounds == rounds + 1, "one round from a bouncing press");
+}
+
+//	A bus fault mid-round loses baskets only while it lasts.  High-rate mode
+//	needs the bus to read every sample, so loses both; window mode counts the
+//	first from the interrupt alone, then stays latched until the bus is back
+static void scriptSensorFault() {
+	selectMode(MODE_TIMED);
+	SimTime start = startRound();
+	for (int i = 0; i < 4; i++) shootAt(start + (1000 + i * 1000ULL) * US_PER_MS);
+	runMs(5500);
+	world.faultUntil = world.now + 1000 * US_PER_MS;	// two baskets lost in here
+	for (int i = 0; i < 2; i++) shootAt(world.now + (300 + i * 500ULL) * US_PER_MS);
+	for (int i = 0; i < 4; i++) shootAt(start + (10000 + i * 1000ULL) * US_PER_MS);
+	runUntilIdle(Config.fullcountMs() + 5000);
+	expectScore(SensorMode == SENSOR_HIGHRATE ? 8 : 9);
+	world.faultUntil = 0;
+}
+
+//	A slave holding SDA low mid-round: the bus is clocked free once, the fault
+//	is counted, and every basket still counts
+static void scriptBusHang() {
+	unsigned long clears = native::bus.clears;
+	unsigned int faults = faultCount(FaultBus);
+
+	selectMode(MODE_TIMED);
+	SimTime start = startRound();
+	for (int i = 0; i < 6; i++) shootAt(start + (1000 + i * 2000ULL) * US_PER_MS);
+	runMs(2000);
+	native::holdSda(true);
+	runUntilIdle(Config.fullcountMs() + 5000);
+	expectScore(6);
+	expect(native::bus.clears == clears + 1, "bus clocked free once");
+	expect(faultCount(FaultBus) == faults + 1, "bus clear counted");
+}
+
+//	loop() hangs until the watchdog resets the part: setup() runs again and
+//	resumes the round from its checkpoint, with the score and the time left
+//	when loop() stopped, give or take the checkpoint period
+static void scriptWarmReset() {
+	unsigned int resumes = faultCount(FaultResume);
+
+	selectMode(MODE_TIMED);
+	SimTime start = startRound();
+	for (int i = 0; i < 3; i++) shootAt(start + (1000 + i * 2000ULL) * US_PER_MS);
+	runMs(8000);
+	expectScore(3);
+	unsigned int left = clockRemaining();
+
+	SimTime hang = 2 * WatchdogMs * US_PER_MS;		// interrupt, then reset
+	native::advanceMicros(hang);
+	world.now += hang;
+	schedTicks();									// the tick kept running through the hang
+	setup();
+	seen.shootStart += hang + CheckpointPeriod * US_PER_MS;	// time given back
+	seen.clockTenths = -1;							// and the clock goes up to match
+	runMs(FRAME_SLACK_MS);
+	expect(shooting, "shooting again after the reset");
+	expect(faultCount(FaultResume) == resumes + 1, "resume counted");
+	unsigned int resumed = clockRemaining() + FRAME_SLACK_MS;	// at the last checkpoint
+	expect(resumed >= left && resumed <= left + CheckpointPeriod, "clock resumed where loop() stopped");
+	expectScore(3);
+	for (int i = 0; i < 2; i++) shootAt(world.now + (1000 + i * 2000ULL) * US_PER_MS);
+	runUntilIdle(Config.fullcountMs() + 5000);
+	expectScore(5);
+}
+
+//	Range errors and single-sample glitches must not count in high-rate mode
+static void scriptNoise() {
+	selectMode(MODE_TIMED);
+	world.errorPct = 50;
+	startRound();
+	runUntilIdle(Config.fullcountMs() + 5000);
+	expectScore(0);
+	world.errorPct = 0;
+#if SensorMode == SENSOR_HIGHRATE
+	world.glitchPct = 20;
+	startRound();
+	runUntilIdle(Config.fullcountMs() + 5000);
+	expectScore(0);
+	world.glitchPct = 0;
+#endif
+}
+
+//	Long presses cycle the modes, each shown as "P<n>" on the clock
+static void scriptModeCycle() {
+	selectMode(MODE_TIMED);
+	for (byte m = 1; m <= MODE_COUNT; m++) {
+		longPress();
+		runMs(Config.longPressMs + 100);
+		char want[3] = { 'P', (char)('0' + (m % MODE_COUNT) + 1), 0 };
+		expectClock(want);
+		runMs(300);
+	}
+	expect(gameMode == MODE_TIMED, "back to the first mode");
+	runMs(2100);
+	expectClock("00");
+}
+
+//	First-to mode ends the round at the target, with the melody; "HI" goes
+//	to the faster time, though every round scores the same baskets
+static void scriptFirstTo() {
+	static const unsigned int gapMs[] = { 1000, 700, 900 };
+	static const bool high[] = { true, true, false };
+
+	selectMode(MODE_FIRST_TO);
+	for (int r = 0; r < 3; r++) {
+		unsigned long melodies = seen.melodies;
+		seen.highShown = false;
+		SimTime start = startRound();
+		for (int i = 0; i < Config.firstToTarget + 3; i++) shootAt(start + (500 + i * gapMs[r]) * US_PER_MS);
+		runUntilIdle(Config.firstToLimitSecs * 1000UL + 10000);
+		expect(world.now < start + (Config.firstToTarget * 1000ULL + 5000) * US_PER_MS, "ended at the target");
+		expectScore(Config.firstToTarget);
+		expect(seen.melodies == melodies + 1, "time-up melody");
+		runMs(HIGH_SCROLL_MS);
+		expect(seen.highShown == high[r], high[r] ? "\"HI\" for a faster time" : "no \"HI\" for a slower time");
+	}
+}
+
+//	Streak mode: a gap longer than streakGapMs breaks the run
+static void scriptStreak() {
+	selectMode(MODE_STREAK);
+	SimTime start = startRound();
+	for (int i = 0; i < 3; i++) shootAt(start + (500 + i * 1000ULL) * US_PER_MS);
+	runMs(3000 + FlashMs);
+	expectScore(3);
+	runMs(Config.streakGapMs);
+	expectScore(0);
+	shootAt(world.now + 200 * US_PER_MS);
+	runMs(300 + FlashMs);							// counted, and done blinking
+	expectScore(1);
+	runUntilIdle(Config.streakRoundSecs * 1000UL + 5000);
+	expect(game[0].best == 3, "best streak 3");
+}
+
+//	Rapid fire: each basket restarts a shorter clock; a miss ends the round
+static void scriptRapid() {
+	selectMode(MODE_RAPID);
+	SimTime start = startRound();
+	SimTime at = start;
+	for (int i = 0; i < 6; i++) at = shootAt(at + 1000 * US_PER_MS);
+	runUntilIdle(60000);
+	expectScore(6);
+	SimTime window = (Config.rapidStartMs - 6 * Config.rapidStepMs) * US_PER_MS;
+	expect(world.now - at < window + 5000 * US_PER_MS, "ended one window after the last basket");
+}
+
+struct Script {
+	const char	*name;
+	void		(*run)();
+};
+
+static const Script scripts[] = {
+	{ "micros wrap",	scriptMicrosWrap },
+	{ "millis wrap",	scriptMillisWrap },
+	{ "last tick",		scriptLastTick },
+	{ "effects",		scriptEffects },
+	{ "precount press",	scriptPrecountPress },
+	{ "cancel",			scriptCancel },
+	{ "bounce",			scriptBounce },
+	{ "sensor fault",	scriptSensorFault },
+	{ "bus hang",		scriptBusHang },
+	{ "warm reset",		scriptWarmReset },
+	{ "noise",			scriptNoise },
+	{ "mode cycle",		scriptModeCycle },
+	{ "first to",		scriptFirstTo },
+	{ "streak",			scriptStreak },
+	{ "rapid fire",		scriptRapid },
+};
+
+//	Random games: mode changes, bouncing and stray presses, shots at random
+//	spacing and transit, glitches, errors, bus faults and hangs, and now and then
+//	a long enough wait to power down
+
+static unsigned long between(unsigned long lo, unsigned long hi) {
+	return lo + rand() % (hi - lo + 1);
+}
+
+static void randomGame() {
+	if (rand() % 4 == 0) {
+		for (int n = between(1, 3); n > 0; n--) {
+			press(between(Config.longPressMs + 50, 2000), 0, rand() % 2);
+			runMs(2200);
+		}
+	}
+	world.glitchPct = rand() % 3 == 0 ? between(0, 10) : 0;
+	world.errorPct = rand() % 3 == 0 ? between(0, 50) : 0;
+	if (rand() % 10 == 0) doublePress();
+	else press(between(30, 600), 0, rand() % 2);
+
+	SimTime t0 = world.now;
+	for (SimTime t = t0 + between(0, 3000) * US_PER_MS; t < t0 + 70000 * US_PER_MS;
+			t += between(150, 3500) * US_PER_MS)
+		ball(t, between(20, 120) * 1000UL);
+	if (rand() % 10 == 0)
+		press(rand() % 3 ? 100 : 1200, between(0, 40000), rand() % 2);
+	if (rand() % 20 == 0) {
+		SimTime at = t0 + between(0, 40000) * US_PER_MS;
+		world.faultUntil = at + between(20, 1500) * US_PER_MS;
+		runTo(at);
+	}
+	if (rand() % 20 == 0) {
+		runTo(t0 + between(0, 40000) * US_PER_MS);
+		native::holdSda(true);						// until the firmware clocks it free
+	}
+	runUntilIdle(120000);
+	world.balls.clear();
+	world.ballHead = 0;
+	world.faultUntil = 0;
+	native::holdSda(false);
+	runMs(between(0, 2000));
+	if (rand() % 50 == 0) runMs(Config.idleTimeoutMs + between(0, 2000));
+}
+
+int main(int argc, char **argv) {
+	unsigned long games = 1000;
+	unsigned int seed = 1;
+	bool verbose = false;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) games = strtoul(argv[++i], 0, 10);
+		else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) seed = strtoul(argv[++i], 0, 10);
+		else if (strcmp(argv[i], "-v") == 0) verbose = true;
+		else {
+			fprintf(stderr, "usage: sim [-n games] [-s seed] [-v]\n");
+			return 2;
+		}
+	}
+
+	native::reset();
+	native::max7219Chain(Config.displayCsPin, Lanes);
+	native::serialEcho(verbose);
+	native::setClock(-(uint32_t)MILLIS_WRAP_MS, -(uint32_t)(MICROS_WRAP_MS * 1000));
+	VL6180X[0].present = false;						// first script: no sensor at power-on
+	world.faultUntil = ~0ULL;
+	srand(seed);
+	setup();
+	seen.quietSince = 0;
+	seen.mode = gameMode;
+
+	std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	scriptBoot();
+	for (size_t i = 0; i < sizeof(scripts) / sizeof(scripts[0]); i++) {
+		unsigned long before = failures;
+		scenario = scripts[i].name;
+		scripts[i].run();
+		printf("%-16s %s\n", scenario, failures == before ? "ok" : "FAILED");
+	}
+	scenario = "random";
+	srand(seed);
+	for (game_ = 1; game_ <= games && failures == 0; game_++)
+		randomGame();
+	game_--;
+	double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+	printf("%lu random games (seed %u), %lu rounds, %.1f h simulated in %.2f s: %.0f games/s, %.0fx real time\n",
+		game_, seed, seen.rounds, world.now / 3.6e9, secs, game_ / secs, world.now / 1e6 / secs);
+	if (failures) {
+		printf("%lu failures, first at %.3f s\n", failures, failedAt / 1e6);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,218 @@
+/**********************************************************************************
+ *
+ *	LaneBench  --  detection latency against the number of lanes shooting at once
+ *
+ *  File:          LaneBench.cpp
+ *
+ *  Function:      Runs the unmodified setup()/loop() built with -D Lanes=n,
+ *                 with every lane's VL6180X wired as on the board (CE pins,
+ *                 INT1 for lane 0, port C pin change for the rest), and plays
+ *                 one round for each count of lanes shooting together, 1 to
+ *                 Lanes.  The shooting lanes all get a ball at the same
+ *                 instant, and every sensor samples in step with the others,
+ *                 the worst case for the shared I2C bus.  Virtual time is
+ *                 charged for the bus as well as the loop, so queued reads
+ *                 wait their turn as they would at 400 kHz.
+ *
+ *                 The button is held through power-on, so every lane is
+ *                 calibrated, each single-shot reading taking PollUs; the
+ *                 lanes after the first do so from loop() with the watchdog
+ *                 armed, and the run fails if it ever went WatchdogMs unkicked.
+ *                 The last lane's first set-up hangs the bus after the sensor
+ *                 has been moved to its lane address, so it must come back
+ *                 through reset and a retry.
+ *
+ *                 Latency is from the ball entering the hoop to the pass
+ *                 that calls scoreIt(); it includes the sensor's own sampling
+ *                 delay, so compare builds rather than read it as overhead.
+ *
+ *                   pio run -e native_lanes -t exec
+ *
+ *                 Change -D Lanes in that env to compare 1 to MaxLanes lanes.
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#include <stdio.h>
+#include <vector>
+#include <algorithm>
+#include "Arduino.h"
+#include "NativeHost.h"
+#include "Config.h"
+#include "Display.h"
+#include "GameMode.h"
+#include "Sensor.h"
+#include "Calibration.h"
+#include "Recovery.h"
+#include "DFRobot_VL6180X.h"
+
+//	Scoreboard.cpp entry points and state under test
+void	setup();
+void	loop();
+extern GameRound game[Lanes];
+extern bool shooting;
+extern DFRobot_VL6180X VL6180X[Lanes];
+
+#define BALL_TRANSIT_US	60000UL		// time a falling ball spends in the sensor's view
+#define BALL_RANGE		60			// mm seen while the ball is in the hoop
+#define EMPTY_RANGE		200			// mm seen across the empty hoop
+#define SHOT_EVERY_US	1500000UL	// between simultaneous shots
+#define LOOP_STEP_US	50			// virtual time charged to each loop() pass
+#define I2C_US			125			// one VL6180X register transaction at 400 kHz
+#define SPI_BYTE_US		1			// one byte to the MAX7219 chain at 8 MHz
+
+struct Lane {
+	std::vector<uint32_t>		entries;	// ball entry times, micros()
+	std::vector<unsigned long>	latency;	// us, one per basket counted
+	int							counted;
+};
+
+static Lane lanes[Lanes];
+static uint32_t nextSample;
+static unsigned long i2cCount, frameSpi, frameBytes;	// bus traffic while shooting
+
+//	The sensors as wired on the board: all held in reset until the firmware
+//	raises their CE, each INT line on its own pin
+static void wireLanes() {
+	for (byte l = 0; l < Lanes; l++) {
+		DFRobot_VL6180X &s = VL6180X[l];
+		s.intPin = Config.laneIntPins[l];
+		s.intLine = l == 0 ? digitalPinToInterrupt(Config.laneIntPins[0]) : NATIVE_PCINT1;
+		s.pinChange = l != 0;
+		if (Lanes > 1) s.cePin = Config.laneCePins[l];
+		s.range = EMPTY_RANGE;					// what calibration sees
+	}
+}
+
+static bool inView(const Lane &lane, uint32_t now) {
+	for (size_t i = 0; i < lane.entries.size(); i++)
+		if (now >= lane.entries[i] && now - lane.entries[i] < BALL_TRANSIT_US) return true;
+	return false;
+}
+
+//	Entry time of the ball a detection stamped at `at` belongs to
+static bool entryOf(const Lane &lane, uint32_t at, uint32_t &entry) {
+	for (size_t i = lane.entries.size(); i-- > 0; ) {
+		if ((int32_t)(at - lane.entries[i]) >= 0) {
+			entry = lane.entries[i];
+			return true;
+		}
+	}
+	return false;
+}
+
+//	One loop() pass, with samples due delivered first and time charged after;
+//	baskets are timed at the end of the pass that counted them
+static void step() {
+	uint32_t now = micros();
+	unsigned long period = VL6180X[0].periodMs_ * 1000UL;
+
+	if (period && (int32_t)(now - nextSample) >= 0) {
+		for (byte l = 0; l < Lanes; l++)
+			VL6180X[l].sample(inView(lanes[l], now) ? BALL_RANGE : EMPTY_RANGE);
+		nextSample += period;
+		if ((int32_t)(now - nextSample) >= 0) nextSample = now + period;	// ranging just started
+	}
+
+	native::BusCounters b0 = native::bus;
+	loop();
+	for (byte l = 0; l < Lanes; l++) {
+		Lane &lane = lanes[l];
+		uint32_t entry;
+		for (; lane.counted < game[l].baskets; lane.counted++)
+			if (entryOf(lane, game[l].lastBasket, entry)) lane.latency.push_back(micros() - entry);
+	}
+	if (shooting) {
+		i2cCount += native::bus.i2c - b0.i2c;
+		frameSpi += native::bus.spi - b0.spi;
+		frameBytes += native::bus.spiBytes - b0.spiBytes;
+	}
+	native::advanceMicros(LOOP_STEP_US + (native::bus.i2c - b0.i2c) * I2C_US
+						  + (native::bus.spiBytes - b0.spiBytes) * SPI_BYTE_US);
+}
+
+static void runFor(unsigned long us) {
+	uint32_t start = micros();
+	while (micros() - start < us) step();
+}
+
+//	Press, run the precount, shoot with the first `shooters` lanes, then let the round end
+static void playRound(byte shooters) {
+	for (byte l = 0; l < Lanes; l++) lanes[l] = Lane();
+
+	native::setPin(Config.buttonPin, LOW);
+	native::raiseInterrupt(digitalPinToInterrupt(Config.buttonPin));
+	runFor(100000);
+	native::setPin(Config.buttonPin, HIGH);
+	native::raiseInterrupt(digitalPinToInterrupt(Config.buttonPin));
+	while (!shooting) step();
+
+	//	shots land at a different point between samples each time
+	uint32_t start = micros();
+	unsigned long windowUs = modeWindowMs() * 1000UL;
+	unsigned long period = VL6180X[0].periodMs_ * 1000UL;
+	for (unsigned long k = 0, t = start + 1000000UL; t + period + BALL_TRANSIT_US < start + windowUs;
+			k++, t += SHOT_EVERY_US) {
+		for (byte l = 0; l < shooters; l++) lanes[l].entries.push_back(t + k * 7919 % period);
+	}
+	i2cCount = frameSpi = frameBytes = 0;
+	while (shooting) step();
+	runFor(3000000UL);							// time-up melody and report
+}
+
+static void report(byte shooters) {
+	double seconds = modeWindowMs() / 1000.0;
+	std::vector<unsigned long> all;
+	size_t balls = 0;
+	int counted = 0;
+
+	for (byte l = 0; l < shooters; l++) {
+		balls += lanes[l].entries.size();
+		counted += lanes[l].counted;
+		all.insert(all.end(), lanes[l].latency.begin(), lanes[l].latency.end());
+	}
+	std::sort(all.begin(), all.end());
+	printf("%8u %7lu %8d", shooters, (unsigned long)balls, counted);
+	if (all.empty()) printf("        -        -        -");
+	else printf(" %8.1f %8.1f %8.1f", all[all.size() / 2] / 1000.0, all[all.size() * 95 / 100] / 1000.0,
+				all.back() / 1000.0);
+	printf(" %8.0f %8.1f %7.1f\n", i2cCount / seconds, frameSpi / seconds,
+		(double)frameBytes / (frameSpi ? frameSpi : 1));
+}
+
+int main() {
+	native::reset();
+	native::serialEcho(false);
+	native::max7219Chain(Config.displayCsPin, Lanes);
+	wireLanes();
+	if (Lanes > 1) VL6180X[Lanes - 1].failSetups = 1;	// first set-up hangs the bus
+	native::setPin(Config.buttonPin, LOW);		// held at power-on: calibrate every lane
+	setup();
+	runFor(Lanes * (CalSamples * PollUs + 100000UL));	// every lane brought up, one at a time
+	native::setPin(Config.buttonPin, HIGH);
+	native::raiseInterrupt(digitalPinToInterrupt(Config.buttonPin));
+	runFor(200000);
+	for (byte l = 0; l < Lanes; l++) {
+		if (!sensorReady(l)) {
+			printf("lane %u sensor did not come up\n", l + 1);
+			return 1;
+		}
+	}
+	if (native::wdtLongestMs() >= WatchdogMs) {
+		printf("watchdog went %lu ms without a kick bringing the lanes up\n", native::wdtLongestMs());
+		return 1;
+	}
+
+	printf("%d lane%s, %s mode, sensors sampling in step, I2C %d us a transaction\n", Lanes,
+		Lanes > 1 ? "s" : "", SensorMode == SENSOR_HIGHRATE ? "high-rate" : "window", I2C_US);
+	printf("shooting   balls  counted   p50 ms   p95 ms   max ms    i2c/s   LOAD/s  B/LOAD\n");
+	for (byte shooters = 1; shooters <= Lanes; shooters++) {
+		playRound(shooters);
+		report(shooters);
+	}
+	return 0;
+}
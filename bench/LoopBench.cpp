@@ -0,0 +1,148 @@
+/**********************************************************************************
+ *
+ *	LoopBench  --  host-native micro-benchmarks for the Scoreboard hot path
+ *
+ *  File:          LoopBench.cpp
+ *
+ *  Function:      Runs the unmodified setup()/loop() from Scoreboard.cpp against
+ *                 the NativeShims library and reports loop iterations per second,
+ *                 the cost of each displayIt() call, and SPI/I2C transactions per
+ *                 loop.  Build and run with:   pio run -e native -t exec
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include "Arduino.h"
+#include "NativeHost.h"
+#include "Config.h"
+#include "Display.h"
+#include "GameMode.h"
+#include "DFRobot_VL6180X.h"
+
+//	Scoreboard.cpp entry points and state under test
+void	setup();
+void	loop();
+extern GameRound game[Lanes];
+extern DFRobot_VL6180X VL6180X[Lanes];
+
+static_assert(Lanes == 1, "LoopBench drives a single lane; see LaneBench for several");
+
+#define BALL_TRANSIT_US	60000UL		// time a falling ball spends in the sensor's view
+#define BALL_RANGE		60			// mm seen while the ball is in the hoop
+#define EMPTY_RANGE		200			// mm seen across the empty hoop
+#define LOOP_STEP_US	50			// virtual time charged to each loop() pass
+
+typedef std::chrono::steady_clock Clock;
+
+static double nsSince(Clock::time_point t0) {
+	return std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+}
+
+static void report(const char *name, unsigned long iters, double ns,
+					unsigned long spi, unsigned long i2c) {
+	printf("%-22s %10lu iters %12.0f iter/s %9.1f ns/iter %8lu spi %8.4f/iter %6lu i2c %8.4f/iter\n",
+		name, iters, iters * 1e9 / ns, ns / iters, spi, (double)spi / iters, i2c, (double)i2c / iters);
+}
+
+//	Idle at the end of a round: button up, no shooting
+static void benchIdle(unsigned long iters) {
+	native::BusCounters b0 = native::bus;
+	Clock::time_point t0 = Clock::now();
+	for (unsigned long i = 0; i < iters; i++) {
+		loop();
+		native::advanceMicros(LOOP_STEP_US);
+	}
+	report("loop idle", iters, nsSince(t0), native::bus.spi - b0.spi, native::bus.i2c - b0.i2c);
+}
+
+//	A full round: button press, precount, 30 s shot clock with a basket every 1.5 s.
+//	The sensor takes a sample every configured inter-measurement period, so
+//	baskets that fall between samples are missed as they would be on the board.
+static void benchRound() {
+	const unsigned long basketEvery = 1500000UL;
+	unsigned long iters = 0;
+	unsigned long nextBasket = 0;
+	unsigned long ballUntil = 0;
+	unsigned long nextSample = 0;
+	int shots = 0;
+	bool inRound = true;
+
+	native::BusCounters b0 = native::bus;
+	native::setPin(Config.buttonPin, LOW);
+	native::raiseInterrupt(0);
+	loop();
+	native::advanceMicros(100000);			// released well after the bounce window
+	native::setPin(Config.buttonPin, HIGH);
+	native::raiseInterrupt(0);
+	unsigned long start = micros();
+	nextBasket = start + 6000000UL;			// first shot once the shot clock is running
+	nextSample = start;
+
+	Clock::time_point t0 = Clock::now();
+	while (inRound) {
+		unsigned long now = micros();
+		if (now >= nextBasket && now < start + 35000000UL) {
+			ballUntil = now + BALL_TRANSIT_US;
+			nextBasket += basketEvery;
+			shots++;
+		}
+		if (now >= nextSample) {
+			VL6180X[0].sample(now < ballUntil ? BALL_RANGE : EMPTY_RANGE);
+			nextSample += VL6180X[0].periodMs_ * 1000UL;
+		}
+		loop();
+		native::advanceMicros(LOOP_STEP_US);
+		iters++;
+		inRound = (micros() - start) < 37000000UL;
+	}
+	report("loop full round", iters, nsSince(t0), native::bus.spi - b0.spi, native::bus.i2c - b0.i2c);
+	printf("%-22s %10d of %d baskets counted\n", "", game[0].baskets, shots);
+}
+
+//	displayIt() alone, with an unchanged value and with every call changing digits,
+//	then staging plus a flush on every frame
+static void benchDisplay(unsigned long iters) {
+	native::BusCounters b0 = native::bus;
+	Clock::time_point t0 = Clock::now();
+	for (unsigned long i = 0; i < iters; i++)
+		displayIt(SCOREDISP, 42);
+	report("displayIt unchanged", iters, nsSince(t0), native::bus.spi - b0.spi, native::bus.i2c - b0.i2c);
+
+	b0 = native::bus;
+	t0 = Clock::now();
+	for (unsigned long i = 0; i < iters; i++)
+		displayIt(CLOCKDISP, (int)(i % 100));
+	report("displayIt changing", iters, nsSince(t0), native::bus.spi - b0.spi, native::bus.i2c - b0.i2c);
+
+	b0 = native::bus;
+	t0 = Clock::now();
+	for (unsigned long i = 0; i < iters; i++) {
+		displayIt(SCOREDISP, (int)(i % 100));
+		displayIt(CLOCKDISP, (int)((i / 10) % 100));
+		displayFlush();
+		native::advanceMicros(FrameInterval * 1000UL);
+	}
+	report("display frame", iters, nsSince(t0), native::bus.spi - b0.spi, native::bus.i2c - b0.i2c);
+}
+
+int main(int argc, char **argv) {
+	unsigned long iters = (argc > 1) ? strtoul(argv[1], 0, 10) : 1000000UL;
+
+	native::reset();
+	native::max7219Chain(Config.displayCsPin, Lanes);
+	setup();
+	printf("setup(): %lu spi, %lu i2c\n", native::bus.spi, native::bus.i2c);
+
+	benchIdle(iters);
+	benchRound();
+	benchIdle(iters);
+	benchDisplay(iters);
+	return 0;
+}
@@ -0,0 +1,128 @@
+/**********************************************************************************
+ *
+ *	TelemetryDecode  --  host-side decoder for the firmware telemetry stream
+ *
+ *  File:          TelemetryDecode.cpp
+ *
+ *  Function:      Reads a raw Serial capture from a nano_telemetry build (file
+ *                 or stdin), splits it into frames at 0x00, COBS-decodes and
+ *                 checks each, and writes one CSV line per record to stdout.
+ *                 Text lines, corrupt frames and sequence gaps are counted on
+ *                 stderr.
+ *
+ *                   pio run -e native_telemetry -t exec -a "capture.bin"
+ *
+ *                 CSV columns: type,seq,micros,then per type
+ *                   state  state,mode,ms_left
+ *                   shot   baskets,score
+ *                   range  range_mm,status
+ *                   loop   misses,max_late_ms,hoop_drops,i2c_timeouts,tlm_dropped
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#include <stdio.h>
+#include <string.h>
+#include "TelemetryFormat.h"
+
+struct Counts {
+	unsigned long records, bad, gaps, lost;
+	unsigned long byType[5];
+};
+
+static const char *stateNames[] = { "idle", "precount", "shooting", "ended", "cancelled", "sleep", "wake" };
+
+//	Same CRC-16/CCITT as crc16() in Calibration.cpp
+static uint16_t crc16(const uint8_t *data, uint8_t len) {
+	uint16_t crc = 0xFFFF;
+	while (len--) {
+		crc ^= (uint16_t)(*data++) << 8;
+		for (uint8_t i = 0; i < 8; i++)
+			crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+	}
+	return crc;
+}
+
+static void printRecord(const uint8_t *r) {
+	const uint8_t *b = r + TlmHeadSize;
+
+	switch (r[0]) {
+		case TlmState:
+			printf("state,%u,%lu,%s,%u,%u\n", r[1], (unsigned long)tlmGet32(b),
+				b[4] <= TlmWake ? stateNames[b[4]] : "?", b[5], tlmGet16(b + 6));
+			break;
+		case TlmShot:
+			printf("shot,%u,%lu,%u,%u\n", r[1], (unsigned long)tlmGet32(b), tlmGet16(b + 4), tlmGet16(b + 6));
+			break;
+		case TlmRange:
+			printf("range,%u,%lu,%u,%u\n", r[1], (unsigned long)tlmGet32(b), b[4], b[5]);
+			break;
+		case TlmLoop:
+			printf("loop,%u,%lu,%u,%u,%u,%u,%u\n", r[1], (unsigned long)tlmGet32(b),
+				tlmGet16(b + 4), tlmGet16(b + 6), b[8], b[9], tlmGet16(b + 10));
+			break;
+	}
+}
+
+//	One delimited frame; false if it is not a valid record
+static bool decodeFrame(const uint8_t *in, size_t len, Counts &c, int &lastSeq) {
+	uint8_t rec[TlmMaxRecord + 1];
+
+	if (len == 0 || len > TlmMaxRecord + 1) return false;
+	uint8_t n = cobsDecode(in, (uint8_t)len, rec);
+	if (n < TlmHeadSize + TlmCrcSize) return false;
+	uint8_t body = tlmBodySize(rec[0]);
+	if (body == 0 || n != TlmHeadSize + body + TlmCrcSize) return false;
+	if (crc16(rec, n - TlmCrcSize) != tlmGet16(rec + n - TlmCrcSize)) return false;
+
+	if (lastSeq >= 0 && rec[1] != ((lastSeq + 1) & 0xFF)) {
+		c.gaps++;
+		c.lost += (rec[1] - lastSeq - 1) & 0xFF;
+	}
+	lastSeq = rec[1];
+	c.records++;
+	c.byType[rec[0]]++;
+	printRecord(rec);
+	return true;
+}
+
+int main(int argc, char **argv) {
+	FILE *f = stdin;
+	uint8_t frame[256];
+	size_t len = 0;
+	bool overflow = false;
+	int lastSeq = -1;
+	int ch;
+	Counts c = Counts();
+
+	if (argc > 2) {
+		fprintf(stderr, "usage: decode [capture.bin]   (stdin if omitted)\n");
+		return 2;
+	}
+	if (argc == 2 && !(f = fopen(argv[1], "rb"))) { perror(argv[1]); return 1; }
+
+	printf("type,seq,micros,a,b,c,d,e\n");
+	while ((ch = fgetc(f)) != EOF) {
+		if (ch != 0) {
+			if (len < sizeof(frame)) frame[len++] = ch;
+			else overflow = true;
+			continue;
+		}
+		//	Between a closing and the next opening delimiter len is 0; anything
+		//	else that fails is text or a damaged record
+		if (len && (overflow || !decodeFrame(frame, len, c, lastSeq))) c.bad++;
+		len = 0;
+		overflow = false;
+	}
+	if (len) c.bad++;						// capture cut mid-frame
+	if (f != stdin) fclose(f);
+
+	fprintf(stderr, "%lu records (state %lu, shot %lu, range %lu, loop %lu), "
+		"%lu bad frames, %lu seq gaps (%lu records lost)\n", c.records, c.byType[TlmState],
+		c.byType[TlmShot], c.byType[TlmRange], c.byType[TlmLoop], c.bad, c.gaps, c.lost);
+	return 0;
+}
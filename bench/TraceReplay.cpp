@@ -0,0 +1,288 @@
+/**********************************************************************************
+ *
+ *	TraceReplay  --  host-side replay of recorded range traces through BallDetector
+ *
+ *  File:          TraceReplay.cpp
+ *
+ *  Function:      Replays one or more BallTrace files (see BallTrace.h) through the
+ *                 same BallDetector the firmware uses and reports detection rate,
+ *                 misses, false positives, latency from true ball entry to the
+ *                 detection event, and replay throughput.  Also converts logged
+ *                 CSV to the trace format and writes synthetic sessions.
+ *
+ *                   pio run -e native_replay -t exec -a "[options] trace.btr ..."
+ *
+ *                   -e mm   enter threshold (default WindowLow, 120)
+ *                   -x mm   exit threshold  (default 135)
+ *                   -c n    samples to confirm a pass (default 2)
+ *                   -w ms   window after a true entry in which a detection
+ *                           counts as a hit (default 150)
+ *                   --csv in.csv out.btr        micros,range,status[,truth] lines
+ *                   --synth out.btr [passes] [seed] [period_ms]
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include "BallDetector.h"
+#include "BallTrace.h"
+
+struct Sample {
+	uint32_t	stamp;
+	uint8_t		range;
+	uint8_t		status;
+};
+
+struct Trace {
+	std::vector<Sample>		samples;
+	std::vector<uint32_t>	truth;			// true ball entry times
+};
+
+struct Result {
+	unsigned long	samples, passes, detected, hits, falsePos;
+	std::vector<uint32_t> latency;			// us, one per hit
+};
+
+//	Trace file I/O
+
+static bool loadTrace(const char *path, Trace &t) {
+	FILE *f = fopen(path, "rb");
+	uint8_t buf[TraceHeaderSize];
+	uint32_t now = 0;
+
+	if (!f) { perror(path); return false; }
+	if (fread(buf, 1, TraceHeaderSize, f) != TraceHeaderSize || memcmp(buf, traceMagic, 4) != 0
+			|| buf[4] != TraceVersion) {
+		fprintf(stderr, "%s: not a version %d trace\n", path, TraceVersion);
+		fclose(f);
+		return false;
+	}
+	while (fread(buf, 1, TraceRecordSize, f) == TraceRecordSize) {
+		TraceRecord r = traceDecode(buf);
+		now += r.dt;
+		if (r.kind == TraceTruth)			t.truth.push_back(now);
+		else if (r.kind < TraceTruth)		t.samples.push_back(Sample{ now, r.range, r.kind });
+	}
+	fclose(f);
+	return true;
+}
+
+class TraceWriter {
+public:
+	explicit TraceWriter(const char *path) : _last(0) {
+		uint8_t hdr[TraceHeaderSize] = { traceMagic[0], traceMagic[1], traceMagic[2], traceMagic[3],
+										 TraceVersion, 0, 0, 0 };
+		_f = fopen(path, "wb");
+		if (_f) fwrite(hdr, 1, TraceHeaderSize, _f);
+		else perror(path);
+	}
+	~TraceWriter() { if (_f) fclose(_f); }
+	bool ok() const { return _f != 0; }
+
+	void put(uint32_t stamp, uint8_t range, uint8_t kind) {
+		uint32_t dt = stamp - _last;
+		while (dt > 0xFFFF) {
+			emit(0xFFFF, 0, TraceSkip);
+			dt -= 0xFFFF;
+		}
+		emit((uint16_t)dt, range, kind);
+		_last = stamp;
+	}
+
+private:
+	void emit(uint16_t dt, uint8_t range, uint8_t kind) {
+		uint8_t out[TraceRecordSize];
+		traceEncode(TraceRecord{ dt, range, kind }, out);
+		fwrite(out, 1, TraceRecordSize, _f);
+	}
+	FILE		*_f;
+	uint32_t	_last;
+};
+
+static int convertCsv(const char *in, const char *out) {
+	FILE *f = fopen(in, "r");
+	char line[128];
+	unsigned long n = 0;
+
+	if (!f) { perror(in); return 1; }
+	TraceWriter w(out);
+	if (!w.ok()) { fclose(f); return 1; }
+	while (fgets(line, sizeof(line), f)) {
+		unsigned long stamp;
+		unsigned int range, status = 0, truth = 0;
+		if (sscanf(line, "%lu,%u,%u,%u", &stamp, &range, &status, &truth) < 2) continue;	// header, blanks
+		if (truth) w.put((uint32_t)stamp, 0, TraceTruth);
+		w.put((uint32_t)stamp, (uint8_t)std::min(range, 255u), (uint8_t)(status & 0x7F));
+		n++;
+	}
+	fclose(f);
+	printf("%s: %lu samples written\n", out, n);
+	return 0;
+}
+
+//	Synthetic session: empty hoop ~180 mm with noise, ball passes of 40-90 ms at
+//	40-110 mm, single-sample noise dips, rim rattles that stay above 120 mm,
+//	and the odd no-target error status
+static int synthesize(const char *out, unsigned long passes, unsigned int seed, unsigned int periodMs) {
+	TraceWriter w(out);
+	uint32_t now = 0, period = periodMs * 1000;
+	unsigned long n = 0;
+
+	if (!w.ok()) return 1;
+	srand(seed);
+	for (unsigned long p = 0; p < passes; p++) {
+		uint32_t entry = now + 800000 + rand() % 2200000;		// 0.8-3 s between shots
+		uint32_t transit = 40000 + rand() % 50000;
+		bool rattle = (rand() % 8) == 0;
+		bool truthWritten = false;
+
+		for (; now < entry + transit + 200000; now += period) {
+			uint8_t range = 172 + rand() % 17;
+			uint8_t status = 0;
+			if (rand() % 500 == 0) range = 100 + rand() % 15;	// one-sample glitch
+			if (rand() % 400 == 0) { range = 255; status = 11; }	// no-target error
+			if (rattle && now + 300000 > entry && now < entry)
+				range = 122 + rand() % 20;						// ball on the rim first
+			if (now >= entry && now < entry + transit)
+				range = 40 + rand() % 70;
+			if (!truthWritten && now + period > entry) {
+				w.put(entry, 0, TraceTruth);
+				truthWritten = true;
+			}
+			w.put(now, range, status);
+			n++;
+		}
+	}
+	printf("%s: %lu passes, %lu samples at %u ms\n", out, passes, n, periodMs);
+	return 0;
+}
+
+//	Replay
+
+static void replay(const Trace &t, const DetectorConfig &cfg, uint32_t window, Result &r) {
+	BallDetector det(cfg);
+	std::vector<bool> matched(t.truth.size(), false);
+	size_t first = 0;
+
+	r.samples += t.samples.size();
+	r.passes += t.truth.size();
+	for (size_t i = 0; i < t.samples.size(); i++) {
+		const Sample &s = t.samples[i];
+		if (!det.feed(s.stamp, s.range, s.status)) continue;
+		r.detected++;
+		while (first < t.truth.size() && t.truth[first] + window < s.stamp) first++;
+		size_t k = first;
+		while (k < t.truth.size() && matched[k]) k++;
+		if (k < t.truth.size() && t.truth[k] <= s.stamp) {
+			matched[k] = true;
+			r.hits++;
+			r.latency.push_back(s.stamp - t.truth[k]);
+		} else {
+			r.falsePos++;
+		}
+	}
+}
+
+static unsigned long replayThroughput(const Trace &t, const DetectorConfig &cfg, double &seconds) {
+	BallDetector det(cfg);
+	unsigned long fed = 0, found = 0;
+	std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+
+	if (t.samples.empty()) { seconds = 0; return 0; }
+	do {
+		for (size_t i = 0; i < t.samples.size(); i++)
+			found += det.feed(t.samples[i].stamp, t.samples[i].range, t.samples[i].status);
+		fed += t.samples.size();
+		seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	} while (fed < 5000000UL && seconds < 2.0);
+	if (found == 0xFFFFFFFFUL) printf(" ");		// keep the loop from being optimised away
+	return fed;
+}
+
+static void printResult(const char *name, const Result &r, unsigned long fed, double seconds) {
+	std::vector<uint32_t> lat = r.latency;
+	std::sort(lat.begin(), lat.end());
+	double mean = 0;
+	for (size_t i = 0; i < lat.size(); i++) mean += lat[i];
+	if (!lat.empty()) mean /= lat.size();
+
+	printf("%s\n", name);
+	printf("  samples %lu, true passes %lu, detected %lu\n", r.samples, r.passes, r.detected);
+	printf("  hits %lu (%.1f%%), misses %lu, false positives %lu\n", r.hits,
+		r.passes ? 100.0 * r.hits / r.passes : 0.0, r.passes - r.hits, r.falsePos);
+	if (!lat.empty())
+		printf("  latency ms: mean %.1f, p50 %.1f, p95 %.1f, max %.1f\n", mean / 1000,
+			lat[lat.size() / 2] / 1000.0, lat[lat.size() * 95 / 100] / 1000.0, lat.back() / 1000.0);
+	if (seconds > 0)
+		printf("  replay %.1f M samples/s\n", fed / seconds / 1e6);
+}
+
+static int usage() {
+	fprintf(stderr, "usage: replay [-e mm] [-x mm] [-c n] [-w ms] trace.btr ...\n"
+					"       replay --csv in.csv out.btr\n"
+					"       replay --synth out.btr [passes] [seed] [period_ms]\n");
+	return 2;
+}
+
+int main(int argc, char **argv) {
+	DetectorConfig cfg = { 120, 135, 2 };
+	uint32_t window = 150000;
+	Result total = Result();
+	unsigned long totalFed = 0;
+	double totalSecs = 0;
+	int files = 0;
+
+	if (argc > 1 && strcmp(argv[1], "--csv") == 0)
+		return argc == 4 ? convertCsv(argv[2], argv[3]) : usage();
+	if (argc > 1 && strcmp(argv[1], "--synth") == 0) {
+		if (argc < 3) return usage();
+		return synthesize(argv[2], argc > 3 ? strtoul(argv[3], 0, 10) : 200,
+						  argc > 4 ? atoi(argv[4]) : 1, argc > 5 ? atoi(argv[5]) : 10);
+	}
+
+	for (int i = 1; i < argc; i++) {
+		if (argv[i][0] == '-' && i + 1 < argc) {
+			int v = atoi(argv[i + 1]);
+			switch (argv[i][1]) {
+				case 'e': cfg.enterBelow = v; break;
+				case 'x': cfg.exitAbove = v; break;
+				case 'c': cfg.confirm = v; break;
+				case 'w': window = v * 1000UL; break;
+				default: return usage();
+			}
+			i++;
+			continue;
+		}
+		Trace t;
+		Result r = Result();
+		double seconds;
+		if (!loadTrace(argv[i], t)) return 1;
+		replay(t, cfg, window, r);
+		unsigned long fed = replayThroughput(t, cfg, seconds);
+		printResult(argv[i], r, fed, seconds);
+
+		total.samples += r.samples;
+		total.passes += r.passes;
+		total.detected += r.detected;
+		total.hits += r.hits;
+		total.falsePos += r.falsePos;
+		total.latency.insert(total.latency.end(), r.latency.begin(), r.latency.end());
+		totalFed += fed;
+		totalSecs += seconds;
+		files++;
+	}
+	if (files == 0) return usage();
+	if (files > 1) printResult("total", total, totalFed, totalSecs);
+	printf("config: enter < %u mm, exit >= %u mm, confirm %u, window %lu ms\n",
+		cfg.enterBelow, cfg.exitAbove, cfg.confirm, (unsigned long)window / 1000);
+	return 0;
+}
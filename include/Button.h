@@ -0,0 +1,39 @@
+/**********************************************************************************
+ *
+ *	Button  --  interrupt-driven, debounced pushbutton with gestures
+ *
+ *  File:          Button.h
+ *
+ *  Function:      An INT0 CHANGE interrupt stamps each accepted edge with micros()
+ *                 and queues it; edges within Config.bounceMs of the last accepted
+ *                 one are contact bounce and ignored.  buttonRead(), called from
+ *                 a task, turns the edges into gestures:
+ *
+ *                   BTN_PRESS   button went down (stamped at the edge)
+ *                   BTN_DOUBLE  went down again within doubleGapMs of a short press,
+ *                               reported instead of a second BTN_PRESS
+ *                   BTN_LONG    still held longPressMs after going down; the
+ *                               BTN_PRESS has already been reported
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#ifndef BUTTON_H
+#define BUTTON_H
+
+#include	<Arduino.h>
+
+#define BTN_NONE		0
+#define BTN_PRESS		1
+#define BTN_DOUBLE		2
+#define BTN_LONG		3
+
+void	buttonBegin(byte pin);				// active low, pulled up; pin must be INT0 or INT1
+void	buttonResume();						// re-attach after sleep; a held button is a press
+byte	buttonRead(uint32_t &stamp);	// next gesture and its micros(), or BTN_NONE
+
+#endif
@@ -0,0 +1,58 @@
+/**********************************************************************************
+ *
+ *	Buzzer  --  timer-driven tone engine playing melodies from flash
+ *
+ *  File:          Buzzer.h
+ *
+ *  Function:      Timer2 in CTC mode toggles the buzzer pin at the note's pitch;
+ *                 buzzerTick(), run in the 1 kHz scheduler tick (schedOnTick),
+ *                 times each note to the millisecond.  Neither depends on how
+ *                 often loop() runs.  A melody is a PROGMEM array of Notes ended
+ *                 by SoundEnd; up to SoundQueueSize melodies wait their turn, and
+ *                 SND_NOW cuts short whatever is sounding without losing the queue.
+ *
+ *                 Timer2 is also what tone() uses, so tone() must not be called.
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#ifndef BUZZER_H
+#define BUZZER_H
+
+#include	<Arduino.h>
+
+//	Note pitches in Hz
+#define NOTE_C4		262
+#define NOTE_E4		330
+#define NOTE_G4		392
+#define NOTE_E5		659
+#define NOTE_A5		880
+#define NOTE_BEEP	2000
+
+//	Timer2 at clk/128 toggling the pin on compare match: 245 Hz and up
+#define Pitch(hz)		((byte)((F_CPU / 256UL + (hz) / 2) / (hz) - 1))
+#define Ms(ms)			((byte)((ms) / 5))		// note lengths are kept in 5 ms steps
+
+struct Note {
+	byte	pitch;				// Timer2 compare value from Pitch(), 0 = rest
+	byte	length;				// Ms() steps, 0 ends the melody
+};
+
+#define Rest			0
+#define SoundEnd		{ Rest, 0 }
+#define SoundQueueSize	4		// melodies waiting, must be a power of 2
+
+#define SND_QUEUE		0		// play after everything already queued
+#define SND_NOW			1		// cut the current melody short and play at once
+
+void	buzzerBegin(byte pin);
+void	buzzerTick();								// tick interrupt only
+bool	buzzerPlay(const Note *melody, byte mode);	// PROGMEM melody; false if queue full
+void	buzzerStop();								// silence and empty the queue
+bool	buzzerBusy();
+
+#endif
@@ -0,0 +1,48 @@
+/**********************************************************************************
+ *
+ *	Calibration  --  per-hoop sensor thresholds persisted in EEPROM
+ *
+ *  File:          Calibration.h
+ *
+ *  Function:      Holding the button while powering on samples the empty hoop
+ *                 and derives the detection threshold from the closest baseline
+ *                 reading.  The result is stored at CalAddress with a version and
+ *                 CRC; normal boots load it in a few EEPROM reads and fall back to
+ *                 the built-in WindowLow if nothing valid has been stored.
+ *                 Lanes past the first keep theirs at CalLaneAddress, in the
+ *                 EEPROM left over after the session log.
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+#include	<Arduino.h>
+
+#define CalAddress		0		// EEPROM offset of the calibration record
+#define CalLaneAddress	976		// records for lanes 1..MaxLanes-1, after the session log
+#define CalVersion		1		// bump when the record layout changes
+#define CalSamples		32		// empty-hoop readings taken when calibrating
+#define CalMargin		30		// mm below the closest baseline reading to trigger
+#define CalMinThreshold	40		// mm; never trigger closer than this
+#define CalMaxThreshold	240		// mm
+
+struct Calibration {
+	byte		version;
+	byte		baseline;		// closest empty-hoop reading (mm), 255 = nothing in range
+	byte		threshold;		// ball present below this range (mm)
+	byte		reserved;
+	uint16_t	crc;			// CRC-16/CCITT of the bytes above
+};
+
+uint16_t	crc16(const byte *data, byte len, uint16_t crc = 0xFFFF);
+bool		calLoad(Calibration &cal, byte lane = 0);	// true if a valid record was read
+void		calSave(Calibration &cal, byte lane = 0);	// sets version and crc, then writes
+byte		calThreshold(byte baseline);		// derive the trigger range from a baseline
+
+#endif
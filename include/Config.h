@@ -0,0 +1,118 @@
+/**********************************************************************************
+ *
+ *	Config  --  game and board settings, checked when compiled
+ *
+ *  File:          Config.h
+ *
+ *  Function:      Every tunable the game logic uses lives in the one constexpr
+ *                 Config below.  Values that follow from others (the full clock
+ *                 setting is shot clock plus precount) are computed, never
+ *                 restated, and the static_asserts reject combinations the
+ *                 firmware cannot honour before anything reaches a board.
+ *
+ *                 Lanes (build flag, default 1) is the number of hoops one
+ *                 controller runs, each with its own VL6180X and MAX7219 in
+ *                 the chain; see the lane pins below.
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include	<Arduino.h>
+
+#ifndef Lanes
+#define Lanes		1			// hoops on this controller (env nano_lanes)
+#endif
+#define MaxLanes	4			// pins below; A3 stays free, A4/A5 are I2C
+#define AllLanes	0xFF		// lane argument: every lane at once
+
+struct GameConfig {
+	byte			shotClockSecs;		// shooting window
+	byte			precountSecs;		// count-in beeps before it
+	unsigned int	basketLockoutMs;	// ignore the detector while the ball passes through
+	unsigned int	tenthsBelowMs;		// clock shows tenths ("9.8") below this
+	unsigned int	pulseBelowMs;		// brightness beats with the seconds below this
+	unsigned long	idleTimeoutMs;		// idle time before powering down
+	unsigned int	sleepFadeMs;		// digits fade out over the last of that
+	byte			bounceMs;			// contact bounce on the pushbutton
+	unsigned int	longPressMs;		// held this long for a long press
+	unsigned int	doubleGapMs;		// release to next press for a double press
+	byte			firstToTarget;		// first-to-N mode: baskets to reach
+	byte			firstToLimitSecs;	//                  ...within this long
+	unsigned int	streakGapMs;		// streak mode: longest gap inside a streak
+	byte			streakRoundSecs;	//              length of the round
+	unsigned int	rapidStartMs;		// rapid-fire mode: first shot window
+	unsigned int	rapidStepMs;		//                  each basket shortens it by
+	unsigned int	rapidMinMs;			//                  down to
+	byte			buttonPin;
+	byte			buzzerPin;
+	byte			displayCsPin;		// MAX7219 LOAD
+	byte			laneIntPins[MaxLanes];	// VL6180X GPIO1: lane 0 on INT1, others pin change on port C
+	byte			laneCePins[MaxLanes];	// VL6180X GPIO0/CE: low holds a sensor off the bus
+
+	constexpr unsigned int fullcountSecs() const	{ return shotClockSecs + precountSecs; }
+	constexpr unsigned long fullcountMs() const		{ return fullcountSecs() * 1000UL; }
+};
+
+constexpr GameConfig Config = {
+	30,			// shotClockSecs
+	5,			// precountSecs
+	200,		// basketLockoutMs
+	10000,		// tenthsBelowMs
+	5000,		// pulseBelowMs
+	300000UL,	// idleTimeoutMs, 5 min
+	2000,		// sleepFadeMs
+	15,			// bounceMs
+	800,		// longPressMs
+	300,		// doubleGapMs
+	10,			// firstToTarget
+	60,			// firstToLimitSecs
+	5000,		// streakGapMs
+	60,			// streakRoundSecs
+	5000,		// rapidStartMs
+	250,		// rapidStepMs
+	1500,		// rapidMinMs
+	2,			// buttonPin
+	5,			// buzzerPin
+	10,			// displayCsPin
+	{ 3, A0, A1, A2 },	// laneIntPins
+	{ 4, 6, 7, 8 },		// laneCePins, unused with one lane
+};
+
+//	A lane pin must not clash with the fixed pins, SPI (11-13) or I2C (A4, A5)
+constexpr bool lanePinFree(byte pin) {
+	return pin != Config.buttonPin && pin != Config.buzzerPin && pin != Config.displayCsPin
+		&& (pin < 11 || pin > 13) && pin != A4 && pin != A5;
+}
+
+constexpr bool lanesWired(byte lane) {
+	return lane >= Lanes || (lanePinFree(Config.laneIntPins[lane]) && lanePinFree(Config.laneCePins[lane])
+		&& (lane == 0 || (Config.laneIntPins[lane] >= A0 && Config.laneIntPins[lane] <= A3))
+		&& lanesWired(lane + 1));
+}
+
+static_assert(Config.shotClockSecs > 0 && Config.precountSecs > 0, "shot clock and precount must both run");
+static_assert(Config.fullcountSecs() <= 99, "clock shows two digits");
+static_assert(Config.fullcountMs() <= 65535UL, "GameClock counts milliseconds in 16 bits");
+static_assert(Config.tenthsBelowMs <= 10000, "tenths display tops out at 9.9");
+static_assert(Config.tenthsBelowMs <= Config.shotClockSecs * 1000UL, "tenths only while shooting");
+static_assert(Config.pulseBelowMs <= Config.shotClockSecs * 1000UL, "pulse only while shooting");
+static_assert(Config.sleepFadeMs < Config.idleTimeoutMs, "fade must start after the last round");
+static_assert(Config.basketLockoutMs < Config.shotClockSecs * 1000UL, "lockout longer than the round");
+static_assert(Config.bounceMs < Config.doubleGapMs && Config.doubleGapMs < Config.longPressMs,
+			  "button gestures must be distinguishable");
+static_assert(Config.buttonPin == 2 || Config.buttonPin == 3, "button must be on INT0/INT1 to wake the MCU");
+static_assert(Config.laneIntPins[0] == 3, "Sensor.cpp attaches lane 0's VL6180X to INT1");
+static_assert(Config.buttonPin != Config.laneIntPins[0], "button and sensor share an interrupt pin");
+static_assert(Config.buzzerPin != Config.buttonPin && (Config.buzzerPin < 11 || Config.buzzerPin > 13),
+			  "buzzer pin already in use");
+static_assert(Lanes >= 1 && Lanes <= MaxLanes, "1 to MaxLanes lanes");
+static_assert(lanesWired(0), "lane pins clash, or a lane past 0 is not on the port C pin-change group");
+
+#endif
@@ -0,0 +1,91 @@
+/**********************************************************************************
+ *
+ *	Display  --  framebuffered MAX7219 driver for the score and clock digits
+ *
+ *  File:          Display.h
+ *
+ *  Function:      displayIt() only updates a 4-digit framebuffer of pre-encoded
+ *                 segment bytes and marks changed digits dirty; it divides only
+ *                 when the value has changed.  displayFlush(), run by the
+ *                 scheduler every FrameInterval, writes every dirty digit back
+ *                 to back, so score and clock changes made in the same pass
+ *                 appear together.
+ *
+ *                 With several lanes the MAX7219s are daisy-chained (DOUT to
+ *                 DIN), lane 0 nearest the MCU.  A dirty digit is sent to every
+ *                 device in one shift of 2 bytes per lane and a single LOAD, so
+ *                 a frame costs one LOAD per changed digit however many lanes
+ *                 changed it.  The lane argument defaults to all of them.
+ *
+ *                 displayFlush() only queues those register writes.  The SPI
+ *                 transfer-complete interrupt sends each byte as the last one
+ *                 finishes, pulls LOAD low before a register's first byte and
+ *                 raises it after the last, so loop() never waits on the
+ *                 shift.  The display owns the SPI bus for good.
+ *
+ *                 Effects are laid over the staged digits when a frame is
+ *                 sent and never touch the framebuffer, so the value shows
+ *                 again as soon as one ends.  Each is a start time and a
+ *                 kind, advanced by displayFlush()'s own millis(): a flash
+ *                 blinks a lane's score digits, a scroll runs PROGMEM
+ *                 segment bytes across all four digits, a pulse beats the
+ *                 brightness with the clock's final seconds and a fade dims
+ *                 every lane to nothing before power-down.  Nothing waits,
+ *                 and a frame is at most one LOAD per digit plus one for the
+ *                 intensity registers.
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+#include	<Arduino.h>
+#include	"Config.h"
+
+#define SCOREDISP  0			// 	Select the score display digits
+#define	CLOCKDISP  1			//  Select the timer display digits
+#define DisplayDigits	4		//  units & tens for score, then units & tens for clock
+#define FrameInterval	20		//  scheduler ticks between display flushes (50 frames/s)
+#define DisplayQueueSize 8		//  register writes waiting for SPI, power of 2 (one slot stays free)
+
+#define DisplayBright	10		//  MAX7219 intensity, 0-15, with no effect running
+#define PulseHigh		15		//  pulse: intensity as each second begins
+#define PulseLow		3		//         ...falling to this by its end
+#define FlashPhaseMs	100		//  flash: score digits off, on, off, on
+#define FlashMs			(4 * FlashPhaseMs)
+#define ScrollStepMs	150		//  scroll: one digit along per step
+#define ScrollPasses	2		//          times the text crosses the display
+#define ScrollMs(len)	((unsigned long)ScrollPasses * ((len) + DisplayDigits) * ScrollStepMs)
+
+//	Segment patterns in MAX7219 no-decode order (DP A B C D E F G), for text
+#define SegE	0x4F
+#define SegH	0x37
+#define SegI	0x06			//  left-hand bars, so it is not read as 1
+#define SegP	0x67
+#define SegDP	0x80			//  decimal point
+
+static_assert((DisplayQueueSize & (DisplayQueueSize - 1)) == 0, "DisplayQueueSize must be a power of 2");
+static_assert(DisplayQueueSize > DisplayDigits + 1, "a frame must fit the display queue");
+
+void	displayBegin(int csPin);				// wake the MAX7219s and blank the digits
+void	displayIt(int dispType, int numToDisp, byte lane = AllLanes);	// stage a 2-digit value
+void	displayTenths(int dispType, int tenths, byte lane = AllLanes);	// stage 0-99 tenths as "9.8"
+void	displayError(int dispType, byte code, byte lane = AllLanes);	// show "E<code>" in place of a value
+void	displayMode(int dispType, byte mode, byte lane = AllLanes);		// show "P<mode>" in place of a value
+void	displayPower(bool on);					// shut down / wake the MAX7219s, if changed
+bool	displayFlush();							// send dirty digits and effects: call once a frame
+byte	displayQueuePeak();						// most register writes queued at once
+void	displayResetStats();
+
+void	displayFlash(byte lane);				// blink the lane's score digits, e.g. on a basket
+void	displayScroll(const byte *text, byte len, byte lane = AllLanes);	// PROGMEM segments, right to left
+void	displayPulse(unsigned int msLeft, byte lane = AllLanes);	// beat brightness with the clock; 0 stops
+void	displayFade(bool out);					// dim every lane over the sleep fade, or restore at once
+void	displayStopEffects(byte lane = AllLanes);	// drop flash, scroll and pulse
+
+#endif
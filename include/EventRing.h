@@ -0,0 +1,59 @@
+/**********************************************************************************
+ *
+ *	EventRing  --  single-producer/single-consumer ring of event timestamps
+ *
+ *  File:          EventRing.h
+ *
+ *  Function:      The hoop-detector ISR pushes the micros() time of each sensor
+ *                 interrupt; loop() pops them in order.  Head is only written by
+ *                 the ISR and tail only by loop(), both single bytes, so neither
+ *                 side has to disable interrupts.  A full ring drops the new
+ *                 event and counts it in overflows.
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#ifndef EVENT_RING_H
+#define EVENT_RING_H
+
+#include	<Arduino.h>
+
+#define EventRingSize	8			// must be a power of 2
+
+class EventRing {
+public:
+	// ISR side
+	inline void push(uint32_t stamp) {
+		byte next = (head + 1) & (EventRingSize - 1);
+		if (next == tail) {
+			if (overflows != 0xFF) overflows++;
+			return;
+		}
+		stamps[head] = stamp;
+		head = next;				// publish only after the slot is written
+	}
+
+	// loop() side
+	inline bool pop(uint32_t &stamp) {
+		if (tail == head) return false;
+		stamp = stamps[tail];
+		tail = (tail + 1) & (EventRingSize - 1);
+		return true;
+	}
+
+	inline void flush()				{ tail = head; }
+	inline byte dropped()			{ return overflows; }
+	inline void clearDropped()		{ overflows = 0; }
+
+private:
+	volatile uint32_t stamps[EventRingSize];
+	volatile byte head = 0;
+	volatile byte tail = 0;
+	volatile byte overflows = 0;	// saturates at 255
+};
+
+#endif
@@ -0,0 +1,33 @@
+/**********************************************************************************
+ *
+ *	GameClock  --  millisecond shot clock counted down by the scheduler tick
+ *
+ *  File:          GameClock.h
+ *
+ *  Function:      clockTick() runs in the 1 kHz Timer1 interrupt (registered with
+ *                 schedOnTick) and decrements the remaining milliseconds, so the
+ *                 count costs loop() nothing and cannot drift behind it.  On the
+ *                 tick that reaches zero it latches the micros() of expiry; the
+ *                 round ends at that instant however late loop() notices, and
+ *                 baskets stamped after it are not counted.
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#ifndef GAME_CLOCK_H
+#define GAME_CLOCK_H
+
+#include	<Arduino.h>
+
+void	clockTick();						// tick interrupt only
+void	clockStart(unsigned int ms);		// up to 65 s
+void	clockStop();
+bool	clockRunning();						// started and not yet expired
+unsigned int clockRemaining();				// ms
+bool	clockEnded(uint32_t &at);		// expired since clockStart(); at = micros()
+
+#endif
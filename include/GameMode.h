@@ -0,0 +1,142 @@
+/**********************************************************************************
+ *
+ *	GameMode  --  game rules as compile-time policies
+ *
+ *  File:          GameMode.h
+ *
+ *  Function:      Each mode is a struct of static functions, its numbers fixed
+ *                 by template arguments taken from Config, so every rule call
+ *                 compiles to a direct (mostly inlined) call with constants
+ *                 folded in.  The only run-time choice is the switch on
+ *                 gameMode in GameMode.cpp.  A policy provides:
+ *
+ *                   windowMs()      shot clock after the precount
+ *                   basket(g)       after g.baskets / g.lastBasket are updated:
+ *                                   set g.score / g.best, return ms to restart
+ *                                   the shot clock with, or 0 to leave it
+ *                   tick(g, now)    every ms while shooting; true ends the round
+ *                                   before the clock runs out
+ *                   report(g)       mode's own words for the round summary
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#ifndef GAME_MODE_H
+#define GAME_MODE_H
+
+#include	<Arduino.h>
+#include	"Config.h"
+
+struct GameRound {
+	int				baskets;		// counted this round
+	int				score;			// shown on the score digits
+	int				best;			// mode's headline figure for the summary
+	uint32_t	started;		// micros() when shooting began
+	uint32_t	lastBasket;		// micros() of the last counted basket
+};
+
+//	Precount + window is counted in 16-bit ms by GameClock and taskButton, so
+//	it must stay within 65535 ms (65 s), inside the clock digits' 99 s
+#define ModeWindowFits(ms)	(Config.precountSecs * 1000UL + (ms) <= 65535UL)
+
+//	Count baskets until the shot clock runs out (the original game)
+template <unsigned int WindowMs>
+struct TimedMode {
+	static_assert(ModeWindowFits(WindowMs), "window too long for the clock");
+	static unsigned int windowMs()					{ return WindowMs; }
+	static unsigned int basket(GameRound &g)		{ g.score = g.best = g.baskets; return 0; }
+	static bool tick(GameRound &, uint32_t)	{ return false; }
+	static void report(const GameRound &)			{}
+	static bool beats(unsigned int best, unsigned int high)	{ return best > high; }
+};
+
+//	Race to Target baskets; best is the time taken in tenths
+template <byte Target, unsigned int LimitMs>
+struct FirstToMode {
+	static_assert(ModeWindowFits(LimitMs), "limit too long for the clock");
+	static_assert(Target > 0 && Target <= 99, "target must fit the score digits");
+	static unsigned int windowMs()					{ return LimitMs; }
+	static unsigned int basket(GameRound &g) {
+		g.score = g.baskets;
+		if (g.baskets == Target) g.best = (g.lastBasket - g.started) / 100000UL;
+		return 0;
+	}
+	static bool tick(GameRound &g, uint32_t)	{ return g.baskets >= Target; }
+	static void report(const GameRound &g) {
+		if (g.baskets < Target) {
+			Serial.println(F("Target not reached"));
+			return;
+		}
+		Serial.print(F("First to "));
+		Serial.print(Target);
+		Serial.print(F(" in "));
+		Serial.print(g.best / 10);
+		Serial.print('.');
+		Serial.print(g.best % 10);
+		Serial.println(F(" s"));
+	}
+	//	a faster time; 0 is the target missed, or no time yet
+	static bool beats(unsigned int best, unsigned int high)	{ return best != 0 && (high == 0 || best < high); }
+};
+
+//	Score is the current run of baskets each within GapMs of the last; best run wins
+template <unsigned int GapMs, unsigned int RoundMs>
+struct StreakMode {
+	static_assert(ModeWindowFits(RoundMs), "round too long for the clock");
+	static unsigned int windowMs()					{ return RoundMs; }
+	static unsigned int basket(GameRound &g) {
+		g.score++;
+		if (g.score > g.best) g.best = g.score;
+		return 0;
+	}
+	static bool tick(GameRound &g, uint32_t now) {
+		if (g.score != 0 && now - g.lastBasket >= GapMs * 1000UL)
+			g.score = 0;						// too slow: the streak is broken
+		return false;
+	}
+	static void report(const GameRound &g) {
+		Serial.print(F("Best streak "));
+		Serial.println(g.best);
+	}
+	static bool beats(unsigned int best, unsigned int high)	{ return best > high; }
+};
+
+//	Each basket restarts a shot clock StepMs shorter, down to MinMs; a miss ends it
+template <unsigned int StartMs, unsigned int StepMs, unsigned int MinMs>
+struct RapidFireMode {
+	static_assert(ModeWindowFits(StartMs) && MinMs <= StartMs, "bad rapid-fire windows");
+	static unsigned int windowMs()					{ return StartMs; }
+	static unsigned int basket(GameRound &g) {
+		g.score = g.best = g.baskets;
+		unsigned long cut = (unsigned long)StepMs * g.baskets;
+		return (cut >= StartMs - MinMs) ? MinMs : StartMs - cut;
+	}
+	static bool tick(GameRound &, uint32_t)	{ return false; }
+	static void report(const GameRound &)			{}
+	static bool beats(unsigned int best, unsigned int high)	{ return best > high; }
+};
+
+typedef TimedMode<Config.shotClockSecs * 1000U>									Timed;
+typedef FirstToMode<Config.firstToTarget, Config.firstToLimitSecs * 1000U>		FirstTo;
+typedef StreakMode<Config.streakGapMs, Config.streakRoundSecs * 1000U>			Streak;
+typedef RapidFireMode<Config.rapidStartMs, Config.rapidStepMs, Config.rapidMinMs>	RapidFire;
+
+#define MODE_TIMED		0			// default
+#define MODE_FIRST_TO	1
+#define MODE_STREAK		2
+#define MODE_RAPID		3
+#define MODE_COUNT		4
+
+extern byte gameMode;
+
+unsigned int modeWindowMs();
+unsigned int modeBasket(GameRound &g);
+bool	modeTick(GameRound &g, uint32_t now);
+void	modeReport(const GameRound &g);
+bool	modeBeats(byte mode, unsigned int best, unsigned int high);	// best is a new high for mode
+
+#endif
@@ -0,0 +1,67 @@
+/**********************************************************************************
+ *
+ *	LatencyTrace  --  optional timing of each stage from an input to its outputs
+ *
+ *  File:          LatencyTrace.h
+ *
+ *  Function:      Follows a basket from the sensor interrupt's micros() stamp
+ *                 to loop() counting it, the Score! beep starting, the score
+ *                 digits queued for SPI and the sensor's interrupt clear
+ *                 completing; and a start press from the button interrupt's
+ *                 stamp to loop() taking the gesture, the first precount beep
+ *                 and the clock digits queued.  Each stage is kept as the
+ *                 time since the interrupt, the first time it is reached,
+ *                 in fixed rings of the last TraceBaskets baskets and
+ *                 TracePresses presses.  The round's end prints the median,
+ *                 90th percentile and maximum of each stage, and clears them.
+ *                 Lane 0 is traced, as for the log and telemetry.
+ *
+ *                 Compiled in only when LATENCY_TRACE is defined (see the
+ *                 nano_trace environment); otherwise every macro is empty.
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#ifndef LATENCY_TRACE_H
+#define LATENCY_TRACE_H
+
+#define TRACE_BASKET	0			// sensor interrupt to score shown
+#define TRACE_BUTTON	1			// button interrupt to precount under way
+#define TRACE_PATHS		2
+
+#define TRACE_LOOP		0			// loop() acts on it: scoreIt(), or the round started
+#define TRACE_BEEP		1			// buzzer sounding
+#define TRACE_DIGITS	2			// score (basket) or clock (button) digits queued for SPI
+#define TRACE_CLEAR		3			// sensor interrupt clear completed (basket only)
+#define TRACE_STAGES	4
+
+#define TraceBaskets	16			// inputs kept for each path; the oldest is overwritten
+#define TracePresses	4
+#define TraceUnitUs		4			// micros() resolution on a 16 MHz AVR; ms past 131 ms
+
+#ifdef LATENCY_TRACE
+
+void traceOpen(byte path, uint32_t stamp);	// a new input, stamped by its interrupt
+void traceMark(byte path, byte stage);			// stage reached by the path's latest input
+void traceReport();								// percentiles over Serial
+void traceReset();
+
+#define TRACE_OPEN(path, stamp)	traceOpen(path, stamp)
+#define TRACE_MARK(path, stage)	traceMark(path, stage)
+#define TRACE_REPORT()			traceReport()
+#define TRACE_ROUND_END()		do { traceReport(); traceReset(); } while (0)
+
+#else
+
+#define TRACE_OPEN(path, stamp)	((void)0)		// a statement still: these sit under if
+#define TRACE_MARK(path, stage)	((void)0)
+#define TRACE_REPORT()
+#define TRACE_ROUND_END()
+
+#endif
+
+#endif
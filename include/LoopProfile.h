@@ -0,0 +1,50 @@
+/**********************************************************************************
+ *
+ *	LoopProfile  --  optional per-section timing of the Scoreboard main loop
+ *
+ *  File:          LoopProfile.h
+ *
+ *  Function:      Records min/max/mean and a coarse log2 histogram of micros()
+ *                 spent in each section of loop() and in the whole iteration.
+ *                 Compiled in only when LOOP_PROFILE is defined (see the
+ *                 nano_profile environment); otherwise every macro is empty.
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#ifndef LOOP_PROFILE_H
+#define LOOP_PROFILE_H
+
+#define PROF_LOOP		0			// full loop() iteration
+#define PROF_CLOCK		1			// clockRemaining()
+#define PROF_BUTTON		2			// buttonRead()
+#define PROF_DISPLAY	3			// stage and flush the frame
+#define PROF_SENSOR		4			// VL6180X I2C traffic
+#define PROF_SECTIONS	5
+#define PROF_BINS		8			// <16us, <32, <64, <128, <256, <512, <1024, >=1024
+
+#ifdef LOOP_PROFILE
+
+void profRecord(byte section, unsigned long elapsed);
+void profReport();					// print all sections over Serial
+void profReset();
+
+#define PROF_BEGIN(sec)		uint32_t profStart_##sec = micros()
+#define PROF_END(sec)		profRecord(sec, micros() - profStart_##sec)
+#define PROF_REPORT()		profReport()
+#define PROF_ROUND_END()	do { profReport(); profReset(); } while (0)
+
+#else
+
+#define PROF_BEGIN(sec)
+#define PROF_END(sec)
+#define PROF_REPORT()
+#define PROF_ROUND_END()
+
+#endif
+
+#endif
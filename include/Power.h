@@ -0,0 +1,29 @@
+/**********************************************************************************
+ *
+ *	Power  --  low-power idle between rounds
+ *
+ *  File:          Power.h
+ *
+ *  Function:      sleepUntilButton() blanks the display, stops the VL6180X
+ *                 ranging and puts the ATmega328 into power-down, with only a
+ *                 low level on the button's INT0 pin able to wake it.  On wake it
+ *                 restarts ranging and the display and returns the wake-to-ready
+ *                 time; the button is still held, so the same press starts the
+ *                 next round.  The watchdog is stopped for the sleep and
+ *                 re-armed on waking.
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#ifndef POWER_H
+#define POWER_H
+
+#include	<Arduino.h>
+
+unsigned long	sleepUntilButton(byte buttonPin);	// returns wake-to-ready time in micros
+
+#endif
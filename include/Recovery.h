@@ -0,0 +1,68 @@
+/**********************************************************************************
+ *
+ *	Recovery  --  watchdog, round checkpoint and fault counts
+ *
+ *  File:          Recovery.h
+ *
+ *  Function:      The hardware watchdog is kicked once per loop().  If loop()
+ *                 stops for WatchdogMs the watchdog interrupt marks a stall,
+ *                 and if it is still stopped WatchdogMs later the part resets.
+ *                 Power-down must stop the watchdog first, or it would end the
+ *                 sleep with a reset.
+ *
+ *                 While the clock runs the round is checkpointed every
+ *                 CheckpointPeriod ms to RAM the C runtime leaves alone
+ *                 (.noinit), sealed with a CRC.  A warm reset (watchdog, reset
+ *                 button, brown-out) keeps it, and setup() resumes the round
+ *                 from it.  A power-up finds random RAM that fails the CRC.
+ *                 Fault counts live there too.  They cover bus clears,
+ *                 stalls and resumed rounds, and last until power is removed.
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#ifndef RECOVERY_H
+#define RECOVERY_H
+
+#include	<Arduino.h>
+#include	"Config.h"
+
+#define WatchdogMs		250		// loop() may stop this long before a stall is counted
+#define CheckpointPeriod 100	// ms of play a reset can lose; each one is CRC-sealed
+
+#define FaultBus		0		// I2C bus clocked free after a timeout
+#define FaultStall		1		// loop() missed the watchdog
+#define FaultResume		2		// round resumed after a warm reset
+#define FaultKinds		3
+
+struct LaneCheckpoint {
+	int				baskets;
+	int				score;
+	int				best;
+	unsigned int	lastMs;		// last basket, ms after shooting began
+	unsigned int	leftMs;		// on this lane's own shot clock
+};
+
+struct Checkpoint {
+	byte			mode;
+	bool			shooting;	// else in the precount
+	unsigned int	clockMs;	// remaining on the shared clock
+	unsigned int	shotMs;		// ms since shooting began
+	LaneCheckpoint	lane[Lanes];
+};
+
+void	watchdogBegin();					// arm, or re-arm after power-down
+void	watchdogKick();						// once per loop()
+void	watchdogStop();						// before power-down
+void	checkpointSave(const Checkpoint &cp);
+bool	checkpointLoad(Checkpoint &cp);		// once at boot: true if a warm reset cut a round short
+void	checkpointClear();					// round over: nothing to resume
+void	faultNote(byte kind);
+unsigned int faultCount(byte kind);			// since power-up, saturating
+unsigned int faultTotal();
+
+#endif
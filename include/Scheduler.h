@@ -0,0 +1,43 @@
+/**********************************************************************************
+ *
+ *	Scheduler  --  timer-ticked cooperative task scheduler
+ *
+ *  File:          Scheduler.h
+ *
+ *  Function:      Timer1 ticks at 1 kHz.  Each subsystem registers a task with
+ *                 its own period in ms; schedRun(), called from loop(), runs every
+ *                 task that has come due, in registration order, and idles the
+ *                 CPU until the next interrupt when nothing was due.  Each task
+ *                 records how late it ran (jitter) and how often it ran a full
+ *                 period or more late (a deadline miss).  A few short hooks
+ *                 can also run inside the tick interrupt itself.
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include	<Arduino.h>
+
+#define SchedMaxTasks	6		// task table size
+#define SchedTickHz		1000	// Timer1 tick rate
+#define SchedMaxHooks	2		// tick interrupt hooks
+
+typedef void (*TaskFn)();
+
+void	schedBegin();								// start the tick
+bool	schedOnTick(TaskFn fn);						// run fn in the tick interrupt
+byte	schedAdd(TaskFn fn, unsigned int periodMs);	// returns the task number
+void	schedRun(bool mayIdle);						// run due tasks; idle if none and mayIdle
+unsigned int schedTicks();							// free-running ms tick count
+unsigned int schedMisses();							// deadline misses, all tasks
+unsigned int schedMaxLate();						// worst lateness (ms), all tasks
+void	schedReport();								// per-task runs / max late / misses
+void	schedResetStats();
+
+#endif
@@ -0,0 +1,98 @@
+/**********************************************************************************
+ *
+ *	Sensor  --  VL6180X hoop detector set-up and servicing
+ *
+ *  File:          Sensor.h
+ *
+ *  Function:      Two acquisition modes, chosen at build time with SensorMode:
+ *
+ *                 SENSOR_WINDOW    the sensor ranges every WindowPeriod ms and
+ *                                  interrupts when the range leaves the
+ *                                  WindowLow..WindowHigh window (original mode)
+ *                 SENSOR_HIGHRATE  the sensor ranges every HighRatePeriod ms and
+ *                                  interrupts on every new sample; loop() reads
+ *                                  each sample (one read + one clear over 400 kHz
+ *                                  I2C) and detects the ball pass in firmware
+ *                                  with BallDetector
+ *
+ *                 Either way each detected pass lands in its lane's hoopEvents
+ *                 stamped with the micros() time of the sensor interrupt.  The
+ *                 trigger range comes from the EEPROM calibration (see
+ *                 Calibration.h).
+ *
+ *                 Bring-up does not block: sensorPoll() makes one begin()
+ *                 attempt when due, backing off while a sensor is missing, and
+ *                 configures it as soon as it answers.
+ *
+ *                 With several lanes every VL6180X boots at the same address,
+ *                 so each sits in reset (CE low) until its turn: raised, given
+ *                 SensorBootMs, then moved to LaneAddress + lane.  Lane 0
+ *                 interrupts on INT1; the rest share the port C pin-change
+ *                 vector, which stamps each line found newly low.  High-rate
+ *                 reads are issued round-robin, one sample per lane per pass.
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#ifndef SENSOR_H
+#define SENSOR_H
+
+#include	<Arduino.h>
+#include	"Config.h"
+#include	"EventRing.h"
+
+#define SENSOR_WINDOW	0
+#define SENSOR_HIGHRATE	1
+
+#ifndef SensorMode
+#define SensorMode		SENSOR_WINDOW
+#endif
+
+#define WindowPeriod	200		// ms between samples in window mode
+#define WindowLow		120		// mm; ball present below this until calibrated
+#define WindowHigh		255		// mm
+#define HighRatePeriod	10		// ms between samples in high-rate mode (sensor minimum)
+#define BallHysteresis	15		// mm above the threshold before the ball counts as gone
+#define BallConfirm		2		// consecutive samples below the threshold to count a pass
+#define SampleBufSize	16		// recent samples kept in high-rate mode, power of 2
+#define SampleGapMs		30		// a longer wait between samples breaks the detector's run
+#define SensorRetryMin	50		// ms before the first retry of a missing sensor
+#define SensorRetryMax	2000	// ms; retry interval doubles up to this
+#define ErrNoSensor		1		// error code shown while the sensor is missing
+#define SensorBootMs	2		// ms from CE high until a VL6180X answers (1.4 max)
+
+#define VL6180X_ADDRESS			0x29	// 7-bit I2C address
+#define LaneAddress				0x2A	// lane n moves to LaneAddress + n when Lanes > 1
+#define SYSTEM__INTERRUPT_CLEAR	0x015	// VL6180X registers used directly
+#define SYSRANGE__START			0x018
+#define RESULT__RANGE_VAL		0x062
+#define ClearRangeInt			0x01
+#define RangeStartStop			0x01	// SYSRANGE__START: stops continuous mode when running
+#define RangeContinuous			0x03	//                  starts continuous mode
+
+struct RangeSample {
+	uint32_t		stamp;		// micros() of the sample-ready interrupt
+	byte			range;		// mm
+};
+
+extern EventRing hoopEvents[Lanes];			// detected ball passes per lane, micros() stamped
+
+void	sensorBegin(bool calibrate);		// start bring-up; calibrate the empty hoops once found
+void	sensorPoll();						// retry missing sensors when due, never blocks
+bool	sensorReady();						// any lane's sensor found, configured and ranging
+bool	sensorReady(byte lane);
+byte	sensorThreshold(byte lane = 0);		// range (mm) below which the ball is present
+void	sensorService();					// read pending samples (high-rate mode only)
+void	sensorRearm(byte lane = AllLanes);	// re-enable detection after a basket
+void	sensorFlush();						// discard detections so far and their drop counts
+byte	sensorDropped();					// detections lost to full rings, all lanes (saturates)
+void	sensorStandby();					// stop continuous ranging before sleep
+void	sensorResume();						// restart ranging after sleep
+unsigned int sensorSampleRate();			// samples/s since the last sensorResetStats(), all lanes
+void	sensorResetStats();
+
+#endif
@@ -0,0 +1,63 @@
+/**********************************************************************************
+ *
+ *	SessionLog  --  per-round history in an EEPROM ring
+ *
+ *  File:          SessionLog.h
+ *
+ *  Function:      Each finished round is kept as one fixed 64-byte slot: round
+ *                 number, mode, baskets, the mode's result, that mode's best
+ *                 result so far and up to LogMaxShots shot times, with a CRC.
+ *                 The best is whatever modeBeats() ranks first: most baskets,
+ *                 the longest streak or the fastest first-to time.
+ *                 Rounds go to the slots in turn, so every cell is written once
+ *                 per LogSlots rounds, and logBegin() finds the newest by round
+ *                 number.  Shots are gathered in RAM; logRound() only closes
+ *                 the record, copying it aside so the next round can gather
+ *                 at once, and logService(), run outside the shot clock
+ *                 while the buzzer is quiet, writes it one EEPROM byte at a
+ *                 time as the EEPROM becomes ready, so no write ever stalls
+ *                 play.  A torn slot fails its
+ *                 CRC and is skipped.
+ *
+ *                 logDump() streams all rounds over Serial, oldest first, one
+ *                 per logService() call:   seq,mode,baskets,result,high,shot ms...
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#ifndef SESSION_LOG_H
+#define SESSION_LOG_H
+
+#include	<Arduino.h>
+
+#define LogAddress		16		// EEPROM offset of the first slot, after the calibration
+#define LogSlotSize		64
+#define LogSlots		15		// 960 bytes, ends at 976
+#define LogMaxShots		26		// shot times kept per round; baskets beyond still count
+#define LogModes		4		// best results kept for this many game modes
+
+struct LogRecord {
+	uint16_t	seq;			// round number since the log began, wraps
+	byte		mode;
+	byte		shots;			// shot times stored below
+	uint16_t	baskets;
+	uint16_t	high;			// best result in any round of this mode
+	uint16_t	result;			// mode's headline figure (GameRound.best)
+	uint16_t	crc;			// CRC-16/CCITT of the fields above and the shots stored
+	uint16_t	shot[LogMaxShots];	// 10 ms units from the start of shooting
+};
+
+void	logBegin();								// find the newest round and the high scores
+void	logNewRound();							// clear the shot list; the last round keeps writing
+void	logShot(unsigned long sinceStartUs);
+void	logRound(byte mode, int baskets, int result);	// close the record for writing
+void	logService();							// write / dump a little; never while shooting
+void	logDump();								// start streaming the log over Serial
+uint16_t logHighScore(byte mode);				// best result of the mode, as modeBeats() ranks it
+uint16_t logRounds();							// round number of the next record
+
+#endif
@@ -0,0 +1,50 @@
+/**********************************************************************************
+ *
+ *	Telemetry  --  framed binary records over Serial without blocking
+ *
+ *  File:          Telemetry.h
+ *
+ *  Function:      Built with -D TELEMETRY (env nano_telemetry).  Each call
+ *                 encodes one fixed-size record (see TelemetryFormat.h) into a
+ *                 TlmBufSize-byte ring, or drops and counts it if there is no
+ *                 room; tlmService(), from loop(), moves only as many bytes to
+ *                 Serial as its TX buffer has free, so sending never waits.
+ *                 Loop statistics go out once per TlmLoopPeriod.  Without
+ *                 TELEMETRY every call compiles to nothing.
+ *
+ *                 Decode a capture on the host:  pio run -e native_telemetry
+ *                 -t exec -a "capture.bin"  (CSV on stdout)
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include	<Arduino.h>
+#include	"TelemetryFormat.h"
+
+#define TlmBufSize		128			// must be a power of 2
+#define TlmLoopPeriod	1000		// millisecs between loop statistics
+
+#ifdef TELEMETRY
+
+void	tlmState(byte state, byte mode, unsigned int remMs);
+void	tlmShot(uint32_t stamp, int baskets, int score);
+void	tlmRange(uint32_t stamp, byte range, byte status);
+void	tlmService();					// drain to Serial, send loop stats when due
+
+#else
+
+inline void	tlmState(byte, byte, unsigned int)				{}
+inline void	tlmShot(uint32_t, int, int)						{}
+inline void	tlmRange(uint32_t, byte, byte)					{}
+inline void	tlmService()									{}
+
+#endif
+
+#endif
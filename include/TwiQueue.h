@@ -0,0 +1,60 @@
+/**********************************************************************************
+ *
+ *	TwiQueue  --  non-blocking queue of I2C register transactions
+ *
+ *  File:          TwiQueue.h
+ *
+ *  Function:      Posts short register reads and writes (16-bit register address,
+ *                 as the VL6180X uses) and completes them in the background,
+ *                 calling the transaction's callback from twiService() with the
+ *                 result.  Transactions run in order, one at a time.
+ *
+ *                 The Wire library (needed by the DFRobot driver for bring-up)
+ *                 already owns TWI_vect, so the queue runs the TWI hardware with
+ *                 its interrupt disabled and twiService() advances the state
+ *                 machine whenever the TWINT flag shows a bus step has finished.
+ *                 Each call costs a few register accesses and never waits on the
+ *                 bus.  A transaction that makes no progress for TwiTimeout us is
+ *                 abandoned and it completes with TWI_TIMEOUT.  The bus is then
+ *                 cleared: a slave stopped mid-byte holds SDA low until SCL is
+ *                 clocked past the rest of its byte, so twiBusClear() pulses SCL
+ *                 by hand (nine at most), sends a STOP and hands the pins back to
+ *                 a fresh TWI unit, all in about 100 us.  Blocking Wire calls are
+ *                 bounded by WireTimeout and cleared the same way by their
+ *                 caller.  Do not mix blocking Wire calls with a busy queue;
+ *                 check twiIdle() first.
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#ifndef TWI_QUEUE_H
+#define TWI_QUEUE_H
+
+#include	<Arduino.h>
+
+#define TwiQueueSize	4		// pending transactions, power of 2
+#define TwiTimeout		2000	// us without bus progress before a transaction is abandoned
+#define TwiMaxData		2		// data bytes written or read per transaction
+#define WireTimeout		5000	// us a blocking Wire call may wait on the bus (setWireTimeout)
+
+#define TWI_OK			0
+#define TWI_NACK		1		// address or data not acknowledged
+#define TWI_ERROR		2		// bus error or lost arbitration
+#define TWI_TIMEOUT		3
+
+typedef void (*TwiCallback)(byte status, const byte *data, uint32_t tag);
+
+bool	twiWriteReg(byte addr, uint16_t reg, byte value, TwiCallback cb = 0, uint32_t tag = 0);
+bool	twiReadReg(byte addr, uint16_t reg, byte len, TwiCallback cb, uint32_t tag = 0);
+void	twiService();					// advance the bus and run completion callbacks
+bool	twiIdle();						// nothing queued or in progress
+byte	twiFree();						// transactions that can be posted now
+bool	twiFlush();						// service until idle; false if one timed out
+byte	twiTimeouts();					// transactions abandoned since boot (saturates)
+bool	twiBusClear();					// clock a stuck slave free; false if SDA is still low
+
+#endif
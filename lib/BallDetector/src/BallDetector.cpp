@@ -0,0 +1,47 @@
+/**********************************************************************************
+ *
+ *	BallDetector  --  ball-pass detection from a stream of range samples
+ *
+ *  File:          BallDetector.cpp
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#include "BallDetector.h"
+
+BallDetector::BallDetector() : _cfg(DetectorConfig{ 0, 0, 1 }) {
+	reset();
+}
+
+BallDetector::BallDetector(const DetectorConfig &cfg) : _cfg(cfg) {
+	reset();
+}
+
+void BallDetector::reset() {
+	_run = 0;
+	_inHoop = false;
+	_entry = 0;
+}
+
+bool BallDetector::feed(uint32_t stamp, uint8_t range, uint8_t status) {
+	if (status != 0) range = 255;				// no valid target: hoop is empty
+
+	if (_inHoop) {
+		if (range >= _cfg.exitAbove) _inHoop = false;
+		return false;
+	}
+	if (range >= _cfg.enterBelow) {
+		_run = 0;
+		return false;
+	}
+	if (_run == 0) _entry = stamp;
+	if (++_run < _cfg.confirm) return false;
+
+	_run = 0;
+	_inHoop = true;
+	return true;
+}
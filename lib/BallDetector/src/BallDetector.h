@@ -0,0 +1,55 @@
+/**********************************************************************************
+ *
+ *	BallDetector  --  ball-pass detection from a stream of range samples
+ *
+ *  File:          BallDetector.h
+ *
+ *  Function:      Pure C++ (no Arduino dependencies) so the same detector runs in
+ *                 the firmware and in the host-side trace replay harness.  Feed
+ *                 it (timestamp, range, status) samples in time order; feed()
+ *                 returns true on the sample that confirms a ball has entered
+ *                 the hoop.
+ *
+ *                 A pass is confirmed after `confirm` consecutive valid samples
+ *                 below `enterBelow` mm.  The detector then re-arms only once a
+ *                 sample reaches `exitAbove` mm, so a ball lingering in view is
+ *                 counted once.  Samples with a non-zero VL6180X error status are
+ *                 treated as "nothing in range".
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#ifndef BALL_DETECTOR_H
+#define BALL_DETECTOR_H
+
+#include <stdint.h>
+
+struct DetectorConfig {
+	uint8_t		enterBelow;		// mm; ball candidate when range is below this
+	uint8_t		exitAbove;		// mm; ball has left once range reaches this
+	uint8_t		confirm;		// consecutive candidate samples needed for a pass
+};
+
+class BallDetector {
+public:
+	BallDetector();								// detects nothing until configure()
+	explicit BallDetector(const DetectorConfig &cfg);
+
+	bool		feed(uint32_t stamp, uint8_t range, uint8_t status);
+	uint32_t	entryTime() const { return _entry; }	// stamp of the first sample of the last pass
+	void		reset();
+	void		configure(const DetectorConfig &cfg) { _cfg = cfg; reset(); }
+	const DetectorConfig &config() const { return _cfg; }
+
+private:
+	DetectorConfig _cfg;
+	uint8_t		_run;			// consecutive candidate samples so far
+	bool		_inHoop;		// pass reported, waiting for the ball to leave
+	uint32_t	_entry;
+};
+
+#endif
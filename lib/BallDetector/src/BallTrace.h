@@ -0,0 +1,62 @@
+/**********************************************************************************
+ *
+ *	BallTrace  --  compact binary format for recorded range traces
+ *
+ *  File:          BallTrace.h
+ *
+ *  Function:      A trace is an 8-byte header followed by 4-byte records, all
+ *                 little-endian:
+ *
+ *                   header   'B' 'T' 'R' 'C'  version(1)  0  0  0
+ *                   record   uint16 dt        micros since the previous record
+ *                            uint8  range     mm
+ *                            uint8  kind      0x00-0x7F  sensor sample, value is
+ *                                                        the VL6180X error status
+ *                                             TraceTruth a ball really entered the
+ *                                                        hoop at this time (labels
+ *                                                        added when annotating)
+ *                                             TraceSkip  time advance only, for
+ *                                                        gaps over 65535 us
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#ifndef BALL_TRACE_H
+#define BALL_TRACE_H
+
+#include <stdint.h>
+
+#define TraceVersion	1
+#define TraceHeaderSize	8
+#define TraceRecordSize	4
+#define TraceTruth		0x80
+#define TraceSkip		0x81
+
+static const uint8_t traceMagic[4] = { 'B', 'T', 'R', 'C' };
+
+struct TraceRecord {
+	uint16_t	dt;
+	uint8_t		range;
+	uint8_t		kind;
+};
+
+inline void traceEncode(const TraceRecord &r, uint8_t *out) {
+	out[0] = r.dt & 0xFF;
+	out[1] = r.dt >> 8;
+	out[2] = r.range;
+	out[3] = r.kind;
+}
+
+inline TraceRecord traceDecode(const uint8_t *in) {
+	TraceRecord r;
+	r.dt = in[0] | (in[1] << 8);
+	r.range = in[2];
+	r.kind = in[3];
+	return r;
+}
+
+#endif
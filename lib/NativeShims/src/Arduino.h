@@ -0,0 +1,92 @@
+/**********************************************************************************
+ *
+ *	Arduino  --  host-native stand-in for the Arduino core
+ *
+ *  File:          Arduino.h
+ *
+ *  Function:      Just enough of the Arduino API for Scoreboard.cpp to build and
+ *                 run on the host.  Time is virtual and only moves when the host
+ *                 program (or delay()) advances it - see NativeHost.h.
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#ifndef ARDUINO_H_NATIVE
+#define ARDUINO_H_NATIVE
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "NativeHost.h"
+#include "avr/pgmspace.h"
+
+#ifndef F_CPU
+#define F_CPU	16000000UL			// as the Nano, for timer arithmetic
+#endif
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 	0x1
+#define LOW  	0x0
+#define INPUT 	0x0
+#define OUTPUT 	0x1
+#define INPUT_PULLUP 0x2
+#define CHANGE 	1
+#define FALLING 2
+#define RISING 	3
+#define LED_BUILTIN 13
+static const uint8_t A0 = 14;		// analog inputs as digital pins, as on the Nano
+static const uint8_t A1 = 15;
+static const uint8_t A2 = 16;
+static const uint8_t A3 = 17;
+static const uint8_t A4 = 18;
+static const uint8_t A5 = 19;
+#define DEC 	10
+#define HEX 	16
+
+#define F(s)	(s)					// no separate flash address space on the host
+#define digitalPinToInterrupt(p)	((p) == 2 ? 0 : ((p) == 3 ? 1 : -1))
+
+uint32_t		millis();				// 32 bits, as the AVR core's unsigned long
+uint32_t		micros();
+void			delay(unsigned long ms);
+void			delayMicroseconds(unsigned int us);
+void			pinMode(uint8_t pin, uint8_t mode);
+int				digitalRead(uint8_t pin);
+void			digitalWrite(uint8_t pin, uint8_t val);
+void			attachInterrupt(uint8_t num, void (*isr)(), int mode);
+void			detachInterrupt(uint8_t num);
+inline void		interrupts() {}
+inline void		noInterrupts() {}
+
+class NativeSerial {
+public:
+	void	begin(unsigned long) {}
+	void	end() {}
+	int		available() { return 0; }
+	int		read() { return -1; }
+	int		availableForWrite() { return 63; }
+	void	flush() {}
+	size_t	write(uint8_t c);
+	size_t	write(const uint8_t *buf, size_t len);
+	size_t	print(const char *s);
+	size_t	print(char c);
+	size_t	print(long n, int base = DEC);
+	size_t	print(unsigned long n, int base = DEC);
+	size_t	print(int n, int base = DEC) { return print((long)n, base); }
+	size_t	print(unsigned int n, int base = DEC) { return print((unsigned long)n, base); }
+	size_t	print(double d, int digits = 2);
+	size_t	println() { return print("\n"); }
+	template <typename T> size_t println(T v) { size_t n = print(v); return n + println(); }
+	template <typename T> size_t println(T v, int f) { size_t n = print(v, f); return n + println(); }
+	operator bool() { return true; }
+};
+
+extern NativeSerial Serial;
+
+#endif
@@ -0,0 +1,166 @@
+/**********************************************************************************
+ *
+ *	DFRobot_VL6180X  --  host-native stand-in for the VL6180X ToF sensor library
+ *
+ *  File:          DFRobot_VL6180X.h
+ *
+ *  Function:      Same method names as the DFRobot driver.  Every call counts its
+ *                 register transactions into native::bus.i2c; the measured range
+ *                 and result status are whatever the host program last set.
+ *
+ *                 Several can share the bus: each answers at its own address,
+ *                 and one given a CE pin is held in reset while that pin is low,
+ *                 coming back at the default address as the real part does.
+ *                 The driver's address is kept apart from the part's, as in
+ *                 the real library: reset moves only the part, so a driver
+ *                 left at a lane address no longer finds it.
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#ifndef DFROBOT_VL6180X_H_NATIVE
+#define DFROBOT_VL6180X_H_NATIVE
+
+#include "Arduino.h"
+#include "Wire.h"
+
+#define VL6180X_IIC_ADDRESS			0x29
+
+#define VL6180X_DIS_INTERRUPT		0
+#define VL6180X_HIGH_INTERRUPT		1
+#define VL6180X_LOW_INTERRUPT		2
+
+#define VL6180X_INT_DISABLE			0
+#define VL6180X_LEVEL_LOW			1
+#define VL6180X_LEVEL_HIGH			2
+#define VL6180X_OUT_OF_WINDOW		3
+#define VL6180X_NEW_SAMPLE_READY	4
+
+#define VL6180X_NO_ERR				0x00
+#define PollUs						10000		// a single-shot range blocks this long
+
+class DFRobot_VL6180X : public native::I2CDevice {
+public:
+	DFRobot_VL6180X(uint8_t addr = VL6180X_IIC_ADDRESS, TwoWire *pWire = &Wire) : address(addr)
+					{ (void)pWire; native::attachI2C(this); }
+	~DFRobot_VL6180X()								{ native::detachI2C(this); }
+
+	// copies only what the real driver holds; the part and its wiring stay
+	DFRobot_VL6180X &operator=(const DFRobot_VL6180X &o)	{ address = o.address; return *this; }
+
+	bool	begin() {
+		native::bus.i2c += 40;
+		if (native::sdaHeld()) {			// gives up after Wire's timeout
+			Wire.timedOut = Wire.timeoutUs != 0;
+			return false;
+		}
+		return native::i2cTarget(address) == this;
+	}
+	void	setInterrupt(uint8_t mode) {
+		native::bus.i2c += 1;
+		if (failSetups) {						// stuck mid-byte: Wire times out
+			failSetups--;
+			native::holdSda(true);
+			Wire.timedOut = Wire.timeoutUs != 0;
+			return;
+		}
+		intMode = mode;
+	}
+	void	rangeConfigInterrupt(uint8_t mode)		{ native::bus.i2c += 2; rangeIntMode = mode; }
+	void	rangeSetInterMeasurementPeriod(uint16_t periodMs) { native::bus.i2c += 1; periodMs_ = periodMs; }
+	bool	setRangeThresholdValue(uint8_t thresholdL, uint8_t thresholdH)
+					{ native::bus.i2c += 2; threshL = thresholdL; threshH = thresholdH; return true; }
+	void	rangeStartContinuousMode()				{ native::bus.i2c += 2; continuous = true; }
+	uint8_t	rangePollMeasurement()					{ native::bus.i2c += 3; native::advanceMicros(PollUs); return range; }
+	uint8_t	rangeGetMeasurement()					{ native::bus.i2c += 1; return range; }
+	uint8_t	rangeGetInterruptStatus()				{ native::bus.i2c += 1; return rangeIntMode; }
+	uint8_t	getRangeResult()						{ native::bus.i2c += 1; return status; }
+	void	clearRangeInterrupt()					{ native::bus.i2c += 1; setInt(false); }
+	void	setIICAddr(uint8_t addr)				{ native::bus.i2c += 1;
+													  if (native::i2cTarget(address) == this) partAddress = addr;
+													  address = addr; }
+
+	// out of reset (CE high, or no CE pin); it ranges whether or not the bus reaches it
+	bool	powered() {
+		if (cePin >= 0 && native::pinLevel(cePin) == LOW) {
+			partAddress = VL6180X_IIC_ADDRESS;			// reset: forgets its address and stops
+			continuous = false;
+			setInt(false);
+			return false;
+		}
+		return true;
+	}
+
+	bool	answers(uint8_t addr)					{ return powered() && present && addr == partAddress; }
+
+	// raw register access for firmware that drives the TWI itself: 16-bit
+	// register address, then data to write or bytes to read
+	bool	transfer(const uint8_t *tx, uint8_t txLen, uint8_t *rx, uint8_t rxLen) {
+		if (txLen < 2) return false;
+		uint16_t reg = (tx[0] << 8) | tx[1];
+		if (txLen > 2 && reg == 0x015) setInt(false);			// SYSTEM__INTERRUPT_CLEAR
+		if (txLen > 2 && reg == 0x018 && (tx[2] & 0x01))		// SYSRANGE__START
+			continuous = (tx[2] & 0x02) != 0;
+		for (uint8_t i = 0; i < rxLen; i++) {
+			switch (reg + i) {
+				case 0x04D:	rx[i] = status << 4; break;			// RESULT__RANGE_STATUS
+				case 0x04F:	rx[i] = intPending ? 4 : 0; break;	// RESULT__INTERRUPT_STATUS_GPIO
+				case 0x062:	rx[i] = range; break;				// RESULT__RANGE_VAL
+				default:	rx[i] = 0; break;
+			}
+		}
+		return true;
+	}
+
+	// host side: deliver one continuous-mode measurement, raising the INT line
+	// (external interrupt intLine) if it meets the configured interrupt condition
+	// and the previous interrupt has been cleared
+	void	sample(uint8_t mm) {
+		bool fire = false;
+		if (!powered()) return;
+		range = mm;
+		switch (rangeIntMode) {
+			case VL6180X_LEVEL_LOW:			fire = mm < threshL; break;
+			case VL6180X_LEVEL_HIGH:		fire = mm > threshH; break;
+			case VL6180X_OUT_OF_WINDOW:		fire = mm < threshL || mm > threshH; break;
+			case VL6180X_NEW_SAMPLE_READY:	fire = true; break;
+		}
+		if (fire && continuous && !intPending && intMode != VL6180X_DIS_INTERRUPT)
+			setInt(true);
+	}
+
+	// INT (GPIO1) asserted or released: drives intPin low while asserted and
+	// raises intLine on assertion, or on both edges for a pin-change line
+	void	setInt(bool on) {
+		if (on == intPending) return;
+		intPending = on;
+		if (intPin >= 0) native::setPin(intPin, on ? LOW : HIGH);
+		if (on || pinChange) native::raiseInterrupt(intLine);
+	}
+
+	// host-side state, set by the program driving the shims
+	bool	present = true;			// begin() succeeds only when the sensor is "connected"
+	int		intLine = 1;			// external interrupt the INT pin is wired to
+	int		intPin = -1;			// MCU pin the INT line drives, if the firmware reads it
+	bool	pinChange = false;		// intLine fires on both edges (NATIVE_PCINT1)
+	int		cePin = -1;				// MCU pin on GPIO0/CE; -1 = always enabled
+	bool	intPending = false;		// INT asserted and not yet cleared
+	uint8_t	range = 255;			// value returned by the next range read (mm)
+	uint8_t	status = VL6180X_NO_ERR;
+	uint8_t	failSetups = 0;			// the next n setInterrupt() calls hang the bus
+	uint8_t	partAddress = VL6180X_IIC_ADDRESS;	// where the part answers
+
+	// last configuration written by the firmware, for inspection by the host
+	uint8_t	address;				// the driver's: where its calls go
+	uint8_t	intMode = VL6180X_DIS_INTERRUPT;
+	uint8_t	rangeIntMode = VL6180X_INT_DISABLE;
+	uint16_t periodMs_ = 0;
+	uint8_t	threshL = 0, threshH = 0;
+	bool	continuous = false;
+};
+
+#endif
@@ -0,0 +1,50 @@
+/**********************************************************************************
+ *
+ *	EEPROM  --  host-native stand-in for the AVR EEPROM library
+ *
+ *  File:          EEPROM.h
+ *
+ *  Function:      1 KB of erased (0xFF) memory, as on the ATmega328.  The host can
+ *                 inspect or preload it through EEPROM.data and count writes.
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#ifndef EEPROM_H_NATIVE
+#define EEPROM_H_NATIVE
+
+#include "Arduino.h"
+
+#define NATIVE_EEPROM_SIZE	1024
+
+class EEPROMClass {
+public:
+	EEPROMClass() { erase(); }
+	uint8_t	read(int idx)					{ return data[idx]; }
+	void	write(int idx, uint8_t val)		{ data[idx] = val; writes++; }
+	void	update(int idx, uint8_t val)	{ if (data[idx] != val) write(idx, val); }
+	uint16_t length()						{ return NATIVE_EEPROM_SIZE; }
+
+	template <typename T> T &get(int idx, T &t) {
+		memcpy(&t, &data[idx], sizeof(T));
+		return t;
+	}
+	template <typename T> const T &put(int idx, const T &t) {
+		const uint8_t *p = (const uint8_t *)&t;
+		for (size_t i = 0; i < sizeof(T); i++) update(idx + i, p[i]);
+		return t;
+	}
+
+	// host side
+	void	erase() { memset(data, 0xFF, sizeof(data)); writes = 0; }
+	uint8_t	data[NATIVE_EEPROM_SIZE];
+	unsigned long writes;					// cells actually programmed
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
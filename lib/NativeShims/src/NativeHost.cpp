@@ -0,0 +1,225 @@
+/**********************************************************************************
+ *
+ *	NativeHost  --  virtual clock, pins, interrupts and peripheral shims
+ *
+ *  File:          NativeHost.cpp
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#include <stdio.h>
+#include "Arduino.h"
+#include "Wire.h"
+#include "SPI.h"
+#include "EEPROM.h"
+
+#define NATIVE_PINS		32
+#define NATIVE_INTS		3
+#define NATIVE_I2C		8			// devices on the bus
+
+namespace native {
+
+BusCounters bus;
+
+static uint32_t nowMicros = 0;
+static uint32_t nowMillis = 0;
+static unsigned int subMillis = 0;		// micros into the current millisecond
+static byte pins[NATIVE_PINS];
+static void (*isrTable[NATIVE_INTS])() = { 0, 0, 0 };
+static I2CDevice *i2cDevices[NATIVE_I2C];
+static int i2cCount = 0;
+static int loadPin = 10;
+static int chainLength = 1;
+static uint8_t shifted[2 * NATIVE_CHAIN];	// chain shift register, [0] nearest DIN
+static bool shiftedSinceLoad = false;
+static uint8_t max7219Regs[NATIVE_CHAIN][16];
+static bool echo = true;
+static uint8_t pitch = 0;
+static unsigned long sleeps = 0;
+static bool wdtOn = false;
+static uint32_t wdtKicked = 0;			// millis() of the last kick, or of arming
+static unsigned long wdtLongest = 0;
+static bool sdaLow = false;
+
+void reset() {
+	setMicros(0);
+	memset(pins, HIGH, sizeof(pins));
+	bus.spi = 0;
+	bus.spiBytes = 0;
+	bus.i2c = 0;
+	bus.clears = 0;
+	sdaLow = false;
+	max7219Chain(10, 1);
+	pitch = 0;
+	sleeps = 0;
+	wdtOn = false;
+	wdtLongest = 0;
+}
+
+void setMicros(uint32_t us)			{ setClock(us / 1000, us); }
+
+void setClock(uint32_t ms, uint32_t us) {
+	nowMillis = ms;
+	nowMicros = us;
+	subMillis = us % 1000;
+}
+
+void advanceMicros(unsigned long us) {
+	nowMicros += us;
+	subMillis += us % 1000;
+	nowMillis += us / 1000 + subMillis / 1000;
+	subMillis %= 1000;
+}
+
+void serialEcho(bool on)				{ echo = on; }
+void toneOut(uint8_t p)					{ pitch = p; }
+uint8_t tonePitch()						{ return pitch; }
+void powerDown()						{ sleeps++; }
+unsigned long powerDowns()				{ return sleeps; }
+
+void wdtRun(bool on) {
+	wdtOn = on;
+	wdtKicked = nowMillis;
+}
+
+void wdtKick() {
+	wdtLongest = wdtLongestMs();
+	wdtKicked = nowMillis;
+}
+
+unsigned long wdtLongestMs() {
+	unsigned long gap = wdtOn ? nowMillis - wdtKicked : 0;
+	return gap > wdtLongest ? gap : wdtLongest;
+}
+
+void setPin(int pin, int level)			{ if (pin >= 0 && pin < NATIVE_PINS) pins[pin] = level; }
+int  pinLevel(int pin)					{ return (pin >= 0 && pin < NATIVE_PINS) ? pins[pin] : LOW; }
+
+void raiseInterrupt(int num) {
+	if (num >= 0 && num < NATIVE_INTS && isrTable[num])
+		isrTable[num]();
+}
+
+void attachI2C(I2CDevice *dev) {
+	if (i2cCount < NATIVE_I2C) i2cDevices[i2cCount++] = dev;
+}
+
+void detachI2C(I2CDevice *dev) {
+	for (int i = 0; i < i2cCount; i++) {
+		if (i2cDevices[i] != dev) continue;
+		i2cDevices[i] = i2cDevices[--i2cCount];
+		return;
+	}
+}
+
+//	Two devices at one address (a sensor left enabled before the last was
+//	moved off the default) corrupt each other's replies: treat as no answer
+I2CDevice *i2cTarget(uint8_t addr) {
+	I2CDevice *found = 0;
+	for (int i = 0; i < i2cCount; i++) {
+		if (!i2cDevices[i]->answers(addr & 0x7F)) continue;
+		if (found) return 0;
+		found = i2cDevices[i];
+	}
+	return found;
+}
+
+bool twiTransfer(uint8_t addr, const uint8_t *tx, uint8_t txLen, uint8_t *rx, uint8_t rxLen) {
+	I2CDevice *dev = i2cTarget(addr);
+	bus.i2c++;
+	return dev && dev->transfer(tx, txLen, rx, rxLen);
+}
+
+void holdSda(bool held)					{ sdaLow = held; }
+bool sdaHeld()							{ return sdaLow; }
+
+//	Nine clocks always get a stuck slave to the end of its byte
+bool busClear() {
+	bus.clears++;
+	sdaLow = false;
+	return true;
+}
+
+//	MAX7219 chain: each byte shifts in at the first device and every word
+//	moves one device along; LOAD rising latches the word each device holds.
+//	A word whose register is no-op (0) leaves that device unchanged.
+
+void max7219Chain(int pin, int devices) {
+	loadPin = pin;
+	chainLength = (devices < 1 || devices > NATIVE_CHAIN) ? NATIVE_CHAIN : devices;
+	memset(shifted, 0, sizeof(shifted));
+	memset(max7219Regs, 0, sizeof(max7219Regs));
+	shiftedSinceLoad = false;
+}
+
+const uint8_t *max7219(int device) {
+	return max7219Regs[(device >= 0 && device < chainLength) ? device : 0];
+}
+
+static void spiShift(uint8_t data) {
+	memmove(shifted + 1, shifted, 2 * chainLength - 1);
+	shifted[0] = data;
+	shiftedSinceLoad = true;
+	bus.spiBytes++;
+}
+
+static void max7219Load() {
+	if (!shiftedSinceLoad) return;
+	shiftedSinceLoad = false;
+	bus.spi++;
+	for (int d = 0; d < chainLength; d++) {
+		uint8_t reg = shifted[2 * d + 1] & 0x0F;
+		if (reg != 0) max7219Regs[d][reg] = shifted[2 * d];
+	}
+}
+
+}	// namespace native
+
+//	Arduino core
+
+NativeSerial Serial;
+TwoWire Wire;
+SPIClass SPI;
+EEPROMClass EEPROM;
+
+uint32_t millis()						{ return native::nowMillis; }
+uint32_t micros()						{ return native::nowMicros; }
+void delay(unsigned long ms)			{ native::advanceMicros(ms * 1000); }
+void delayMicroseconds(unsigned int us)	{ native::advanceMicros(us); }
+void pinMode(uint8_t, uint8_t)			{}
+int  digitalRead(uint8_t pin)			{ return native::pinLevel(pin); }
+void digitalWrite(uint8_t pin, uint8_t val) {
+	bool rising = val != LOW && native::pinLevel(pin) == LOW;
+	native::setPin(pin, val);
+	if (rising && pin == native::loadPin) native::max7219Load();
+}
+
+uint8_t SPIClass::transfer(uint8_t data) {
+	native::spiShift(data);
+	return 0;
+}
+
+void attachInterrupt(uint8_t num, void (*isr)(), int) {
+	if (num < NATIVE_INTS) native::isrTable[num] = isr;
+}
+
+void detachInterrupt(uint8_t num) {
+	if (num < NATIVE_INTS) native::isrTable[num] = 0;
+}
+
+//	With echo off output is dropped, so simulations at speed don't print every report
+size_t NativeSerial::write(uint8_t c)		{ return native::echo ? fwrite(&c, 1, 1, stdout) : 1; }
+size_t NativeSerial::write(const uint8_t *buf, size_t len)	{ return native::echo ? fwrite(buf, 1, len, stdout) : len; }
+size_t NativeSerial::print(const char *s)	{ return (native::echo && fputs(s, stdout) < 0) ? 0 : strlen(s); }
+size_t NativeSerial::print(char c)			{ return write((uint8_t)c); }
+size_t NativeSerial::print(long n, int base) {
+	return native::echo ? printf(base == HEX ? "%lX" : "%ld", n) : 1;
+}
+size_t NativeSerial::print(unsigned long n, int base) {
+	return native::echo ? printf(base == HEX ? "%lX" : "%lu", n) : 1;
+}
+size_t NativeSerial::print(double d, int digits) { return native::echo ? printf("%.*f", digits, d) : 1; }
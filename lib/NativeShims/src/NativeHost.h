@@ -0,0 +1,80 @@
+/**********************************************************************************
+ *
+ *	NativeHost  --  control surface for the host-native hardware shims
+ *
+ *  File:          NativeHost.h
+ *
+ *  Function:      Lets host programs (benchmarks, replay, simulation) drive the
+ *                 virtual clock, pin levels, external interrupts and a hung I2C
+ *                 bus seen by the Scoreboard code, and read back bus counters, the
+ *                 buzzer tone, power-downs, the longest wait for a watchdog kick
+ *                 and what each MAX7219 in the chain has latched.
+ *
+ *                 millis() and micros() are separate 32-bit counters, as on
+ *                 the board, so setClock() can start either just short of its
+ *                 wrap at 2^32 to exercise rollover.
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#ifndef NATIVE_HOST_H
+#define NATIVE_HOST_H
+
+#include <stdint.h>
+
+namespace native {
+
+struct BusCounters {
+	unsigned long spi;			// MAX7219 LOAD pulses (one register in every device of the chain)
+	unsigned long spiBytes;		// bytes shifted into the chain
+	unsigned long i2c;			// VL6180X register transactions
+	unsigned long clears;		// I2C bus clears (SCL clocked by hand)
+};
+
+#define NATIVE_PCINT1	2		// virtual interrupt standing in for PCINT1_vect (pins A0-A5)
+#define NATIVE_CHAIN	8		// MAX7219s the chain model can hold
+
+extern BusCounters bus;
+
+//	A simulated I2C slave, reached by raw transfers from the firmware's own TWI code
+class I2CDevice {
+public:
+	virtual bool answers(uint8_t addr) = 0;		// powered and at this 7-bit address
+	virtual bool transfer(const uint8_t *tx, uint8_t txLen, uint8_t *rx, uint8_t rxLen) = 0;
+	virtual ~I2CDevice() {}
+};
+
+void	reset();								// clock to zero, pins high, counters cleared
+void	setMicros(uint32_t us);					// set the virtual clock
+void	setClock(uint32_t ms, uint32_t us);		// set millis() and micros() apart
+void	advanceMicros(unsigned long us);		// move the virtual clock forward
+void	setPin(int pin, int level);				// level returned by digitalRead(pin)
+int		pinLevel(int pin);						// last level written or set on pin
+void	raiseInterrupt(int num);				// invoke handler attached to interrupt num
+void	attachI2C(I2CDevice *dev);				// joins the bus, answering as dev->answers() says
+void	detachI2C(I2CDevice *dev);				// leaves it
+I2CDevice *i2cTarget(uint8_t addr);				// the one device answering; 0 if none, or a clash
+bool	twiTransfer(uint8_t addr, const uint8_t *tx, uint8_t txLen,	// write then read;
+					uint8_t *rx, uint8_t rxLen);					// false on NACK
+void	holdSda(bool held);						// a slave stuck mid-byte: the bus hangs until cleared
+bool	sdaHeld();
+bool	busClear();								// firmware: SCL clocked by hand; true once SDA is free
+void	max7219Chain(int loadPin, int devices);	// chain length and LOAD pin (default pin 10, 1)
+const uint8_t *max7219(int device);				// registers latched by a device, 0 nearest the MCU
+void	serialEcho(bool on);					// Serial output to stdout (default) or dropped
+
+void	toneOut(uint8_t pitch);					// firmware: Timer2 compare value, 0 = silent
+uint8_t	tonePitch();							// what the buzzer is sounding now
+void	powerDown();							// firmware: entering power-down; returns at once
+unsigned long powerDowns();						// times powered down since reset()
+void	wdtRun(bool on);						// firmware: watchdog armed or stopped
+void	wdtKick();								// firmware: watchdog reset
+unsigned long wdtLongestMs();					// longest the armed watchdog went unkicked
+
+}	// namespace native
+
+#endif
@@ -0,0 +1,41 @@
+/**********************************************************************************
+ *
+ *	SPI  --  host-native stand-in for the Arduino SPI library
+ *
+ *  File:          SPI.h
+ *
+ *  Function:      Bytes sent go to the MAX7219 chain model in NativeHost.cpp,
+ *                 which latches them into each device's registers on the rising
+ *                 edge of its LOAD pin - see native::max7219Chain().
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#ifndef SPI_H_NATIVE
+#define SPI_H_NATIVE
+
+#include "Arduino.h"
+
+#define MSBFIRST	1
+#define SPI_MODE0	0x00
+
+class SPISettings {
+public:
+	SPISettings(uint32_t, uint8_t, uint8_t) {}
+};
+
+class SPIClass {
+public:
+	void	begin() {}
+	void	beginTransaction(const SPISettings &) {}
+	void	endTransaction() {}
+	uint8_t	transfer(uint8_t data);
+};
+
+extern SPIClass SPI;
+
+#endif
@@ -0,0 +1,33 @@
+/**********************************************************************************
+ *
+ *	Wire  --  host-native stand-in for the Arduino TWI library
+ *
+ *  File:          Wire.h
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#ifndef WIRE_H_NATIVE
+#define WIRE_H_NATIVE
+
+#include "Arduino.h"
+
+class TwoWire {
+public:
+	void	begin() {}
+	void	setClock(uint32_t hz) { clock = hz; }
+	void	setWireTimeout(uint32_t us, bool reset) { timeoutUs = us; (void)reset; }
+	bool	getWireTimeoutFlag() { return timedOut; }
+	void	clearWireTimeoutFlag() { timedOut = false; }
+	uint32_t clock = 100000;
+	uint32_t timeoutUs = 0;		// 0: blocking calls would wait for ever
+	bool	timedOut = false;	// set by the shims when a call meets a hung bus
+};
+
+extern TwoWire Wire;
+
+#endif
@@ -0,0 +1,32 @@
+/**********************************************************************************
+ *
+ *	pgmspace  --  host-native stand-in for avr-libc program memory access
+ *
+ *  File:          avr/pgmspace.h
+ *
+ *  Function:      The host has one address space, so PROGMEM is a no-op and the
+ *                 pgm_read_* accessors are plain loads.
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#ifndef PGMSPACE_H_NATIVE
+#define PGMSPACE_H_NATIVE
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PSTR(s)					(s)
+#define pgm_read_byte(p)		(*(const uint8_t *)(p))
+#define pgm_read_word(p)		(*(const uint16_t *)(p))
+#define pgm_read_dword(p)		(*(const uint32_t *)(p))
+#define pgm_read_ptr(p)			(*(void * const *)(p))
+#define memcpy_P				memcpy
+#define strlen_P				strlen
+
+#endif
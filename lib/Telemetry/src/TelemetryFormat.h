@@ -0,0 +1,120 @@
+/**********************************************************************************
+ *
+ *	TelemetryFormat  --  binary telemetry records and their framing
+ *
+ *  File:          TelemetryFormat.h
+ *
+ *  Function:      Shared by the firmware and the host decoder.  A record is
+ *
+ *                   uint8  type     TlmState, TlmShot, TlmRange, TlmLoop
+ *                   uint8  seq      increments per record sent; gaps = drops
+ *                   body            fixed size for the type, little-endian
+ *                   uint16 crc      CRC-16/CCITT (0xFFFF start) of type..body
+ *
+ *                 COBS-encoded and sent between 0x00 delimiters, one before
+ *                 and one after, so text on the same port costs at most the
+ *                 frame it lands in and the decoder resynchronises at the
+ *                 next zero.
+ *
+ *                   TlmState  uint32 micros, uint8 state, uint8 mode, uint16 ms left
+ *                   TlmShot   uint32 micros, uint16 baskets, uint16 score
+ *                   TlmRange  uint32 micros, uint8 range mm, uint8 status
+ *                   TlmLoop   uint32 micros, uint16 task misses, uint16 max late ms,
+ *                             uint8 hoop ring drops, uint8 I2C timeouts,
+ *                             uint16 telemetry records dropped
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#ifndef TELEMETRY_FORMAT_H
+#define TELEMETRY_FORMAT_H
+
+#include <stdint.h>
+
+#define TlmState		0x01
+#define TlmShot			0x02
+#define TlmRange		0x03
+#define TlmLoop			0x04
+
+#define TlmHeadSize		2			// type, seq
+#define TlmCrcSize		2
+#define TlmMaxBody		12
+#define TlmMaxRecord	(TlmHeadSize + TlmMaxBody + TlmCrcSize)
+#define TlmMaxFrame		(TlmMaxRecord + 1 + 2)	// COBS overhead, two delimiters
+
+//	TlmState states
+#define TlmIdle			0
+#define TlmPrecount		1
+#define TlmShooting		2
+#define TlmEnded		3
+#define TlmCancelled	4
+#define TlmSleep		5
+#define TlmWake			6
+
+//	Body size for a record type, 0 if unknown
+inline uint8_t tlmBodySize(uint8_t type) {
+	switch (type) {
+		case TlmState:	return 8;
+		case TlmShot:	return 8;
+		case TlmRange:	return 6;
+		case TlmLoop:	return 12;
+		default:		return 0;
+	}
+}
+
+inline void tlmPut16(uint8_t *p, uint16_t v) {
+	p[0] = v & 0xFF;
+	p[1] = v >> 8;
+}
+
+inline void tlmPut32(uint8_t *p, uint32_t v) {
+	tlmPut16(p, v & 0xFFFF);
+	tlmPut16(p + 2, v >> 16);
+}
+
+inline uint16_t tlmGet16(const uint8_t *p) {
+	return p[0] | (p[1] << 8);
+}
+
+inline uint32_t tlmGet32(const uint8_t *p) {
+	return tlmGet16(p) | ((uint32_t)tlmGet16(p + 2) << 16);
+}
+
+//	COBS: replaces every zero so 0x00 can delimit frames.  out needs len + 1
+//	bytes for records under 254 bytes; returns the encoded length
+inline uint8_t cobsEncode(const uint8_t *in, uint8_t len, uint8_t *out) {
+	uint8_t code = 1, codeAt = 0, n = 1;
+
+	for (uint8_t i = 0; i < len; i++) {
+		if (in[i] == 0) {
+			out[codeAt] = code;
+			code = 1;
+			codeAt = n++;
+		} else {
+			out[n++] = in[i];
+			code++;
+		}
+	}
+	out[codeAt] = code;
+	return n;
+}
+
+//	Inverse of cobsEncode() for one frame without its delimiters; 0 if malformed
+inline uint8_t cobsDecode(const uint8_t *in, uint8_t len, uint8_t *out) {
+	uint8_t n = 0, i = 0;
+
+	while (i < len) {
+		uint8_t code = in[i++];
+		if (code == 0 || i + code - 1 > len) return 0;
+		for (uint8_t k = 1; k < code; k++)
+			out[n++] = in[i++];
+		if (code < 0xFF && i < len) out[n++] = 0;
+	}
+	return n;
+}
+
+#endif
@@ -0,0 +1,42 @@
+#	PlatformIO extra script: report SRAM and flash use after linking and fail
+#	the build when either exceeds the budget set in platformio.ini
+#
+#	  custom_sram_budget  = bytes of .data + .bss (the stack gets the rest)
+#	  custom_flash_budget = bytes of .text + .data
+
+Import("env")
+
+import subprocess
+
+SECTIONS = {
+	"sram":  (".data", ".bss", ".noinit"),
+	"flash": (".text", ".data"),
+}
+
+
+def section_sizes(elf):
+	out = subprocess.check_output([env.subst("$SIZETOOL"), "-A", elf]).decode()
+	sizes = {}
+	for line in out.splitlines():
+		parts = line.split()
+		if len(parts) >= 2 and parts[0].startswith(".") and parts[1].isdigit():
+			sizes[parts[0]] = int(parts[1])
+	return sizes
+
+
+def check_budget(source, target, env):
+	sizes = section_sizes(str(target[0]))
+	failed = False
+	for name in ("sram", "flash"):
+		used = sum(sizes.get(s, 0) for s in SECTIONS[name])
+		budget = int(env.GetProjectOption("custom_%s_budget" % name))
+		status = "ok" if used <= budget else "OVER BUDGET"
+		print("%-5s %6d of %6d bytes budgeted (%3d%%)  %s" % (name, used, budget, used * 100 // budget, status))
+		failed = failed or used > budget
+	if failed:
+		print("Size budget exceeded: trim the build or raise the budget in platformio.ini")
+		return 1
+	return 0
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", check_budget)
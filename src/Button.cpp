@@ -0,0 +1,106 @@
+/**********************************************************************************
+ *
+ *	Button  --  interrupt-driven, debounced pushbutton with gestures
+ *
+ *  File:          Button.cpp
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#include	<Arduino.h>
+#include	"Config.h"
+#include	"EventRing.h"
+#include	"Button.h"
+
+//	Accepted edges, stamp with the new pin level in bit 0 (micros() counts in
+//	4 us steps on a 16 MHz part, so no timing is lost)
+static EventRing edges;
+static byte buttonPin;
+static volatile byte lastLevel = HIGH;					// level after the last accepted edge
+static volatile uint32_t contactBounceTime;		// micros() of the last accepted edge
+static volatile bool unsettled = false;					// edge ignored inside the bounce window
+
+//	Gesture state, loop() side only
+static bool down = false;
+static bool longSent = false;
+static bool lastShort = false;			// previous press was released before longPressMs
+static bool downDouble = false;			// current press was reported as BTN_DOUBLE
+static uint32_t downAt = 0;
+static uint32_t upAt = 0;
+
+static void isr_button() {
+	uint32_t now = micros();
+	byte level = digitalRead(buttonPin);
+
+	if (now - contactBounceTime < Config.bounceMs * 1000UL) {
+		unsettled = true;				// check the settled level once the window closes
+		return;
+	}
+	if (level == lastLevel) return;
+	lastLevel = level;
+	contactBounceTime = now;
+	edges.push((now & ~1UL) | level);
+}
+
+void buttonBegin(byte pin) {
+	buttonPin = pin;
+	pinMode(pin, INPUT_PULLUP);
+	lastLevel = digitalRead(pin);
+	contactBounceTime = micros() - Config.bounceMs * 1000UL;
+	attachInterrupt(digitalPinToInterrupt(pin), isr_button, CHANGE);
+}
+
+void buttonResume() {
+	noInterrupts();
+	lastLevel = HIGH;					// treat the waking press as a fresh edge
+	contactBounceTime = micros() - Config.bounceMs * 1000UL;
+	isr_button();
+	interrupts();
+	attachInterrupt(digitalPinToInterrupt(buttonPin), isr_button, CHANGE);
+}
+
+//	A press shorter than the bounce window, or a bounce that settles back, leaves
+//	the last accepted level wrong; read the pin once the window has passed
+static void settle() {
+	if (!unsettled) return;
+	noInterrupts();
+	if (micros() - contactBounceTime >= Config.bounceMs * 1000UL) {
+		unsettled = false;
+		isr_button();
+	}
+	interrupts();
+}
+
+byte buttonRead(uint32_t &stamp) {
+	uint32_t edge;
+
+	settle();
+	while (edges.pop(edge)) {
+		if (edge & 1) {					// released
+			if (down) {
+				down = false;
+				upAt = edge;
+				lastShort = !longSent && !downDouble;	// a third quick press starts over
+			}
+			continue;
+		}
+		if (down) continue;				// lost a release in an overflow
+		bool dbl = lastShort && (edge - upAt) < Config.doubleGapMs * 1000UL;
+		down = true;
+		longSent = false;
+		downDouble = dbl;
+		downAt = edge;
+		stamp = edge;
+		return dbl ? BTN_DOUBLE : BTN_PRESS;
+	}
+	if (down && !longSent && micros() - downAt >= Config.longPressMs * 1000UL) {
+		longSent = true;
+		stamp = downAt + Config.longPressMs * 1000UL;
+		return BTN_LONG;
+	}
+	return BTN_NONE;
+}
@@ -0,0 +1,127 @@
+/**********************************************************************************
+ *
+ *	Buzzer  --  timer-driven tone engine playing melodies from flash
+ *
+ *  File:          Buzzer.cpp
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#include	<Arduino.h>
+#include	"Buzzer.h"
+
+//	Everything below is shared with buzzerTick(); loop() side changes it only
+//	with interrupts off
+static const Note *queue[SoundQueueSize];
+static volatile byte qHead = 0, qTail = 0;
+static const Note *volatile playing = 0;		// next note to fetch, 0 = silent
+static volatile unsigned int noteLeft = 0;		// ms left of the current note
+
+#if defined(__AVR__)
+
+static volatile uint8_t *buzzerPort;
+static uint8_t buzzerMask;
+
+ISR(TIMER2_COMPA_vect) {
+	*buzzerPort ^= buzzerMask;
+}
+
+static inline void pitchOn(byte ocr) {
+	OCR2A = ocr;
+	TCNT2 = 0;							// a lower compare value must not be overrun
+	TCCR2B = _BV(CS22) | _BV(CS20);		// clk/128
+	TIMSK2 = _BV(OCIE2A);
+}
+
+static inline void pitchOff() {
+	TIMSK2 = 0;
+	TCCR2B = 0;
+	*buzzerPort &= ~buzzerMask;			// no DC through the transducer
+}
+
+void buzzerBegin(byte pin) {
+	pinMode(pin, OUTPUT);
+	digitalWrite(pin, LOW);
+	buzzerPort = portOutputRegister(digitalPinToPort(pin));
+	buzzerMask = digitalPinToBitMask(pin);
+	TCCR2A = _BV(WGM21);				// CTC on OCR2A
+	pitchOff();
+}
+
+#else	// host build: the simulator reads the pitch back
+
+#include	"NativeHost.h"
+
+static inline void pitchOn(byte ocr)	{ native::toneOut(ocr); }
+static inline void pitchOff()			{ native::toneOut(0); }
+void buzzerBegin(byte)					{}
+
+#endif
+
+//	Sound the next note of the playing melody, or start the next queued one
+static void nextNote() {
+	Note n = { Rest, 0 };
+
+	if (playing) {
+		memcpy_P(&n, playing, sizeof(Note));
+		playing = n.length ? playing + 1 : 0;
+	}
+	if (!playing && qHead != qTail) {
+		playing = queue[qTail];
+		qTail = (qTail + 1) & (SoundQueueSize - 1);
+		memcpy_P(&n, playing, sizeof(Note));
+		playing = n.length ? playing + 1 : 0;
+	}
+	if (n.length == 0) {
+		pitchOff();
+		noteLeft = 0;
+		return;
+	}
+	if (n.pitch == Rest) pitchOff();
+	else pitchOn(n.pitch);
+	noteLeft = n.length * 5;
+}
+
+void buzzerTick() {
+	if (noteLeft != 0 && --noteLeft == 0)
+		nextNote();
+}
+
+bool buzzerPlay(const Note *melody, byte mode) {
+	bool queued = true;
+
+	noInterrupts();
+	if (mode == SND_NOW) {
+		playing = melody;
+		nextNote();
+	} else if (noteLeft == 0 && qHead == qTail) {
+		playing = melody;				// idle: no need to wait for a tick
+		nextNote();
+	} else {
+		byte next = (qHead + 1) & (SoundQueueSize - 1);
+		if (next == qTail) queued = false;
+		else {
+			queue[qHead] = melody;
+			qHead = next;
+		}
+	}
+	interrupts();
+	return queued;
+}
+
+void buzzerStop() {
+	noInterrupts();
+	qTail = qHead;
+	playing = 0;
+	noteLeft = 0;
+	pitchOff();
+	interrupts();
+}
+
+bool buzzerBusy() {
+	return noteLeft != 0;
+}
@@ -0,0 +1,64 @@
+/**********************************************************************************
+ *
+ *	Calibration  --  per-hoop sensor thresholds persisted in EEPROM
+ *
+ *  File:          Calibration.cpp
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#include	<Arduino.h>
+#include	<EEPROM.h>
+#include	"Config.h"
+#include	"Calibration.h"
+
+#define CalCrcBytes	(sizeof(Calibration) - sizeof(uint16_t))
+
+static_assert(CalLaneAddress + (MaxLanes - 1) * sizeof(Calibration) <= 1024,
+			  "lane calibration runs past the ATmega328 EEPROM");
+
+static inline int calAddress(byte lane) {
+	return lane == 0 ? CalAddress : CalLaneAddress + (lane - 1) * sizeof(Calibration);
+}
+
+//	CRC-16/CCITT, a nibble at a time from a 32-byte table: a quarter of the
+//	time of the bitwise loop, for little more flash.  Besides the calibration
+//	it seals the recovery checkpoint, every CheckpointPeriod of a round
+static const uint16_t crcNibble[16] PROGMEM = {
+	0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+	0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+uint16_t crc16(const byte *data, byte len, uint16_t crc) {
+	while (len--) {
+		byte b = *data++;
+		crc = (crc << 4) ^ pgm_read_word(&crcNibble[(crc >> 12) ^ (b >> 4)]);
+		crc = (crc << 4) ^ pgm_read_word(&crcNibble[(crc >> 12) ^ (b & 0x0F)]);
+	}
+	return crc;
+}
+
+bool calLoad(Calibration &cal, byte lane) {
+	EEPROM.get(calAddress(lane), cal);
+	return cal.version == CalVersion
+		&& cal.crc == crc16((const byte *)&cal, CalCrcBytes)
+		&& cal.threshold >= CalMinThreshold && cal.threshold <= CalMaxThreshold;
+}
+
+void calSave(Calibration &cal, byte lane) {
+	cal.version = CalVersion;
+	cal.reserved = 0;
+	cal.crc = crc16((const byte *)&cal, CalCrcBytes);
+	EEPROM.put(calAddress(lane), cal);				// put() only rewrites cells that changed
+}
+
+byte calThreshold(byte baseline) {
+	int threshold = (int)baseline - CalMargin;
+	if (threshold < CalMinThreshold) threshold = CalMinThreshold;
+	if (threshold > CalMaxThreshold) threshold = CalMaxThreshold;
+	return threshold;
+}
@@ -0,0 +1,427 @@
+/**********************************************************************************
+ *
+ *	Display  --  framebuffered MAX7219 driver for the score and clock digits
+ *
+ *  File:          Display.cpp
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#include	<Arduino.h>
+#include	<SPI.h>				//  hardware SPI: DIN on pin 11, CLK on pin 13
+#include	"Display.h"
+#include	"LatencyTrace.h"
+
+//	MAX7219 registers
+#define RegNoop			0x00
+#define RegDigit0		0x01				//  digits 0-7 at 0x01-0x08
+#define RegDecode		0x09
+#define RegIntensity	0x0A
+#define RegScanLimit	0x0B
+#define RegShutdown		0x0C				//  0 = shut down, 1 = normal operation
+#define RegTest			0x0F
+
+static const SPISettings max7219Spi(10000000, MSBFIRST, SPI_MODE0);
+
+//	Segment patterns for 0-9 in MAX7219 no-decode order (DP A B C D E F G)
+static const byte digitSegs[10] PROGMEM = {
+	0x7E, 0x30, 0x6D, 0x79, 0x33, 0x5B, 0x5F, 0x70, 0x7F, 0x7B
+};
+
+//	Digit positions from the left as mounted: clock tens and units, then score
+static const byte fromLeft[DisplayDigits] = { 3, 2, 1, 0 };
+
+#define ShownTenths	0x4000				//  shown[] flag: value was staged as tenths
+#define DirtyLevel	0x80				//  dirty flag: an intensity may have changed
+
+static byte frame[DisplayDigits][Lanes];	// segment bytes as they should appear, by digit then lane
+static byte latched[DisplayDigits][Lanes];	// ...and as the MAX7219s hold them, effects included
+static byte level[Lanes];				// intensity each MAX7219 holds
+static byte dirty = 0;					// bit n set = digit n staged anew, or DirtyLevel
+static int	shown[Lanes][2];			// last value staged for score & clock
+static byte loadPin;
+static bool awake = false;
+
+//	Effects, bit n of a mask for lane n
+static byte flashing = 0;
+static byte scrolling = 0;
+static byte pulsing = 0;
+static bool fading = false;
+static uint32_t flashStart[Lanes], scrollStart[Lanes], fadeStart;
+static const byte *scrollText[Lanes];
+static byte scrollLen[Lanes];
+static unsigned int pulseLeft[Lanes];	// clock millisecs at the last displayPulse()
+
+//	Register writes waiting for the SPI hardware, one per LOAD: the same
+//	register in every MAX7219 of the chain
+struct ChainWrite {
+	byte	reg;
+	byte	values[Lanes];
+};
+
+static ChainWrite queue[DisplayQueueSize];
+static volatile byte qHead = 0, qTail = 0;
+static volatile bool sending = false;	// queue[qTail] is going out
+static volatile byte sendPos;			// its byte on the wire, 0 to 2 * Lanes - 1
+static byte qPeak = 0;
+
+//	Byte pos of the word at qTail: the far end of the chain goes first,
+//	register then value
+static inline byte wordByte(byte pos) {
+	const ChainWrite &w = queue[qTail];
+	return (pos & 1) ? w.values[Lanes - 1 - pos / 2] : w.reg;
+}
+
+#if defined(__AVR__)
+
+static volatile uint8_t *loadPort;
+static uint8_t loadMask;
+
+static inline void loadLow()		{ *loadPort &= ~loadMask; }
+static inline void loadHigh()		{ *loadPort |= loadMask; }
+static inline void spiSend(byte b)	{ SPDR = b; }
+
+//	Interrupts off, and back as the caller had them
+static inline byte irqSave()		{ byte s = SREG; cli(); return s; }
+static inline void irqRestore(byte s)	{ SREG = s; }
+
+#else	// host build: the SPI stand-in takes each byte at once
+
+static inline void loadLow()		{ digitalWrite(loadPin, LOW); }
+static inline void loadHigh()		{ digitalWrite(loadPin, HIGH); }
+static inline void spiSend(byte b)	{ SPI.transfer(b); }
+
+static inline byte irqSave()		{ noInterrupts(); return 0; }
+static inline void irqRestore(byte)	{ interrupts(); }
+
+#endif
+
+static inline void wordStart() {
+	loadLow();
+	sendPos = 0;
+	spiSend(wordByte(0));
+}
+
+//	A byte has gone: send the next, or latch the word with LOAD rising and
+//	start the next one.  Runs in the SPI interrupt on the board
+static void byteSent() {
+	if (++sendPos < 2 * Lanes) {
+		spiSend(wordByte(sendPos));
+		return;
+	}
+	loadHigh();
+	qTail = (qTail + 1) & (DisplayQueueSize - 1);
+	if (qTail == qHead) sending = false;
+	else wordStart();
+}
+
+#if defined(__AVR__)
+ISR(SPI_STC_vect) {
+	byteSent();
+}
+#endif
+
+//	Queue one register for every MAX7219 of the chain, and start the hardware
+//	if it is idle.  Never waits: with the queue full, a write of the same
+//	register not yet on the wire takes the new values, and failing that the
+//	write is refused, false, for the caller to send again later.  A frame
+//	needs DisplayDigits + 1 slots at most
+static bool chainWrite(byte reg, const byte *values) {
+	byte s = irqSave();
+	byte next = (qHead + 1) & (DisplayQueueSize - 1);
+	if (next == qTail) {
+		bool merged = false;
+		for (byte i = (qTail + 1) & (DisplayQueueSize - 1); i != qHead; i = (i + 1) & (DisplayQueueSize - 1)) {
+			if (queue[i].reg == reg) {			// queue[qTail] is going out: not that one
+				memcpy(queue[i].values, values, sizeof(queue[i].values));
+				merged = true;
+				break;
+			}
+		}
+		irqRestore(s);
+		return merged;
+	}
+	ChainWrite &w = queue[qHead];
+	w.reg = reg;
+	memcpy(w.values, values, sizeof(w.values));
+	qHead = next;
+	byte depth = (qHead - qTail) & (DisplayQueueSize - 1);
+	if (depth > qPeak) qPeak = depth;
+	bool start = !sending;
+	if (start) {
+		sending = true;
+		wordStart();
+	}
+	irqRestore(s);
+#if !defined(__AVR__)
+	while (start && sending) byteSent();	// no interrupt: each byte is done once sent
+#endif
+	return true;
+}
+
+//	Until the last LOAD has risen
+static void chainWait() {
+	while (sending) ;
+}
+
+//	Bring-up and power changes are not redrawn by a later frame, so these
+//	wait the few us for a slot rather than be refused
+static void chainWriteAll(byte reg, byte value) {
+	byte values[Lanes];
+	memset(values, value, sizeof(values));
+	while (!chainWrite(reg, values)) ;
+}
+
+//	Lanes a call applies to: one, or all for AllLanes
+static inline byte firstLane(byte lane)	{ return lane == AllLanes ? 0 : lane; }
+static inline byte endLane(byte lane)	{ return lane == AllLanes ? Lanes : lane + 1; }
+
+//	Stage segments for one digit, marking it dirty only if they change
+static inline void setFrame(byte lane, byte digit, byte segs) {
+	if (frame[digit][lane] != segs) {
+		frame[digit][lane] = segs;
+		dirty |= 1 << digit;
+	}
+}
+
+void displayBegin(int csPin) {
+	loadPin = csPin;
+	pinMode(loadPin, OUTPUT);
+	digitalWrite(loadPin, HIGH);
+	SPI.begin();
+	SPI.beginTransaction(max7219Spi);	// the display has the bus to itself: never ended
+#if defined(__AVR__)
+	loadPort = portOutputRegister(digitalPinToPort(loadPin));
+	loadMask = digitalPinToBitMask(loadPin);
+	SPCR |= _BV(SPIE);					// byteSent() on each completed byte
+#endif
+
+	/*
+   	The MAX72XX is in power-saving mode on startup,
+   	we have to do a wakeup call
+   	*/
+	chainWriteAll(RegTest, 0);
+	chainWriteAll(RegScanLimit, 7);
+	chainWriteAll(RegDecode, 0);			// raw segments from digitSegs
+	for (byte digit = 0; digit < 8; digit++)
+		chainWriteAll(RegDigit0 + digit, 0);	// and clear the display
+	chainWriteAll(RegIntensity, DisplayBright);	// Set the brightness to a medium values
+	chainWriteAll(RegShutdown, 1);
+	awake = true;
+	memset(frame, 0, sizeof(frame));	// framebuffer matches the blank display
+	memset(latched, 0, sizeof(latched));
+	memset(level, DisplayBright, sizeof(level));
+	dirty = 0;
+	flashing = scrolling = pulsing = 0;
+	fading = false;
+	for (byte lane = 0; lane < Lanes; lane++)
+		shown[lane][SCOREDISP] = shown[lane][CLOCKDISP] = -1;
+	chainWait();
+	qPeak = 0;							// bring-up overfills the queue by design
+}
+
+//	Stage 2 digits for either Score count or Countdown timer
+//       dispType = SCOREDISP (=0) or CLOCKDISP (=1)
+//
+void displayIt(int dispType, int numToDisp, byte lane) {
+	byte digOffset = 2 * dispType;				//  0 address offset for Score display, 2 for Countdown display
+
+	for (byte l = firstLane(lane); l < endLane(lane); l++) {
+		if (shown[l][dispType] == numToDisp) continue;	// nothing changed: no division, no SPI
+		shown[l][dispType] = numToDisp;
+
+		byte units = numToDisp % 10;			// units is displayed on digits 0 & 2
+		byte tens = (numToDisp / 10) % 10;		// tens displayed on digits 1 & 3
+
+		setFrame(l, 0 + digOffset, pgm_read_byte(&digitSegs[units]));
+		setFrame(l, 1 + digOffset, pgm_read_byte(&digitSegs[tens]));
+	}
+}
+
+//	Stage tenths of a second with the decimal point after the seconds digit
+void displayTenths(int dispType, int tenths, byte lane) {
+	byte digOffset = 2 * dispType;
+
+	for (byte l = firstLane(lane); l < endLane(lane); l++) {
+		if (shown[l][dispType] == (tenths | ShownTenths)) continue;
+		shown[l][dispType] = tenths | ShownTenths;
+
+		setFrame(l, 0 + digOffset, pgm_read_byte(&digitSegs[tenths % 10]));
+		setFrame(l, 1 + digOffset, pgm_read_byte(&digitSegs[(tenths / 10) % 10]) | SegDP);
+	}
+}
+
+//	Stage a letter and a single digit on either pair of digits
+static void displayCode(int dispType, byte letter, byte code, byte lane) {
+	byte digOffset = 2 * dispType;
+
+	for (byte l = firstLane(lane); l < endLane(lane); l++) {
+		shown[l][dispType] = -1;				// next displayIt() redraws the value
+		setFrame(l, 0 + digOffset, pgm_read_byte(&digitSegs[code % 10]));
+		setFrame(l, 1 + digOffset, letter);
+	}
+}
+
+void displayError(int dispType, byte code, byte lane) {
+	displayCode(dispType, SegE, code, lane);
+}
+
+void displayMode(int dispType, byte mode, byte lane) {
+	displayCode(dispType, SegP, mode, lane);
+}
+
+//	Waking ends a fade before the digits light, so they never show dimmed.
+//	Shutting down waits for the queue: power-down stops the SPI clock
+void displayPower(bool on) {
+	if (on && fading) {
+		fading = false;
+		memset(level, DisplayBright, sizeof(level));
+		chainWriteAll(RegIntensity, DisplayBright);
+	}
+	if (on != awake) {
+		awake = on;
+		chainWriteAll(RegShutdown, on ? 1 : 0);
+	}
+	if (!on) chainWait();
+}
+
+byte displayQueuePeak() {
+	return qPeak;
+}
+
+void displayResetStats() {
+	qPeak = 0;
+}
+
+void displayFlash(byte lane) {
+	for (byte l = firstLane(lane); l < endLane(lane); l++) {
+		flashing |= 1 << l;
+		flashStart[l] = millis();
+	}
+}
+
+void displayScroll(const byte *text, byte len, byte lane) {
+	for (byte l = firstLane(lane); l < endLane(lane); l++) {
+		scrolling |= 1 << l;
+		scrollStart[l] = millis();
+		scrollText[l] = text;
+		scrollLen[l] = len;
+	}
+}
+
+void displayPulse(unsigned int msLeft, byte lane) {
+	for (byte l = firstLane(lane); l < endLane(lane); l++) {
+		if (msLeft) pulsing |= 1 << l;
+		else if (pulsing & (1 << l)) {
+			pulsing &= ~(1 << l);
+			dirty |= DirtyLevel;			// one more frame to restore the brightness
+		}
+		pulseLeft[l] = msLeft;
+	}
+}
+
+void displayFade(bool out) {
+	if (out == fading) return;
+	fading = out;
+	fadeStart = millis();
+	dirty |= DirtyLevel;
+}
+
+void displayStopEffects(byte lane) {
+	for (byte l = firstLane(lane); l < endLane(lane); l++) {
+		byte bit = 1 << l;
+		if ((flashing | scrolling | pulsing) & bit) dirty |= DirtyLevel;
+		flashing &= ~bit;
+		scrolling &= ~bit;
+		pulsing &= ~bit;
+	}
+}
+
+//	End effects that have run their course, so this frame restores the digits
+static void expireEffects(uint32_t now) {
+	for (byte l = 0; l < Lanes; l++) {
+		byte bit = 1 << l;
+		if ((flashing & bit) && now - flashStart[l] >= FlashMs) flashing &= ~bit;
+		if ((scrolling & bit) && now - scrollStart[l] >= ScrollMs(scrollLen[l])) scrolling &= ~bit;
+	}
+}
+
+//	Segments a digit shows this frame: the staged value unless an effect covers it
+static byte effectSegs(byte lane, byte digit, uint32_t now) {
+	byte bit = 1 << lane;
+
+	if (scrolling & bit) {
+		byte span = scrollLen[lane] + DisplayDigits;
+		byte step = (now - scrollStart[lane]) / ScrollStepMs % span;
+		int i = step + fromLeft[digit] + 1 - DisplayDigits;	// text enters at the right
+		return (i >= 0 && i < scrollLen[lane]) ? pgm_read_byte(&scrollText[lane][i]) : 0;
+	}
+	if ((flashing & bit) && digit < 2 && ((now - flashStart[lane]) / FlashPhaseMs) % 2 == 0)
+		return 0;
+	return frame[digit][lane];
+}
+
+//	Intensity a lane shows this frame: bright at each of the clock's last
+//	seconds, falling through it, and never above the sleep fade
+static byte effectLevel(byte lane, uint32_t now) {
+	byte l = DisplayBright;
+
+	if (pulsing & (1 << lane))
+		l = PulseLow + (unsigned int)(PulseHigh - PulseLow) * (pulseLeft[lane] % 1000) / 1000;
+	if (fading) {
+		uint32_t t = now - fadeStart;
+		byte f = t >= Config.sleepFadeMs ? 0 : DisplayBright - DisplayBright * t / Config.sleepFadeMs;
+		if (f < l) l = f;
+	}
+	return l;
+}
+
+//	Write every digit that differs from what the chain holds, then the
+//	intensities.  The scheduler's Timer1 ticks pace the frames: a millis()
+//	gate here would drop a frame whenever Timer0's 1.024 ms steps made
+//	FrameInterval ticks read as one ms short
+bool displayFlush() {
+	if (dirty == 0 && (flashing | scrolling | pulsing) == 0 && !fading) return false;
+	uint32_t now = millis();
+	dirty = 0;
+	expireEffects(now);
+
+	bool sent = false;
+	byte out[Lanes];
+	for (byte digit = 0; digit < DisplayDigits; digit++) {
+		bool changed = false;
+		for (byte l = 0; l < Lanes; l++) {
+			out[l] = effectSegs(l, digit, now);
+			changed |= out[l] != latched[digit][l];
+		}
+		if (changed) {
+			if (!chainWrite(RegDigit0 + digit, out)) {
+				dirty |= 1 << digit;				// queue full: try again next frame
+				continue;
+			}
+			if (out[0] != latched[digit][0])		// lane 0's score is digits 0-1, its clock 2-3
+				TRACE_MARK(digit < 2 ? TRACE_BASKET : TRACE_BUTTON, TRACE_DIGITS);
+			memcpy(latched[digit], out, sizeof(out));
+			sent = true;
+		}
+	}
+
+	bool changed = false;
+	for (byte l = 0; l < Lanes; l++) {
+		out[l] = effectLevel(l, now);
+		changed |= out[l] != level[l];
+	}
+	if (changed) {
+		if (!chainWrite(RegIntensity, out)) {
+			dirty |= DirtyLevel;
+			return sent;
+		}
+		memcpy(level, out, sizeof(out));
+		sent = true;
+	}
+	return sent;
+}
@@ -0,0 +1,59 @@
+/**********************************************************************************
+ *
+ *	GameClock  --  millisecond shot clock counted down by the scheduler tick
+ *
+ *  File:          GameClock.cpp
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#include	<Arduino.h>
+#include	"GameClock.h"
+
+static volatile unsigned int remainMs = 0;
+static volatile bool ended = false;
+static volatile uint32_t endedAt = 0;
+
+void clockTick() {
+	if (remainMs != 0 && --remainMs == 0) {
+		endedAt = micros();
+		ended = true;
+	}
+}
+
+void clockStart(unsigned int ms) {
+	noInterrupts();
+	remainMs = ms;
+	ended = false;
+	interrupts();
+}
+
+void clockStop() {
+	noInterrupts();
+	remainMs = 0;
+	ended = false;
+	interrupts();
+}
+
+bool clockRunning() {
+	return clockRemaining() != 0;
+}
+
+unsigned int clockRemaining() {
+	noInterrupts();
+	unsigned int ms = remainMs;
+	interrupts();
+	return ms;
+}
+
+bool clockEnded(uint32_t &at) {
+	if (!ended) return false;
+	noInterrupts();
+	at = endedAt;
+	interrupts();
+	return true;
+}
@@ -0,0 +1,63 @@
+/**********************************************************************************
+ *
+ *	GameMode  --  game rules as compile-time policies
+ *
+ *  File:          GameMode.cpp
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#include	<Arduino.h>
+#include	"GameMode.h"
+
+byte gameMode = MODE_TIMED;
+
+unsigned int modeWindowMs() {
+	switch (gameMode) {
+		case MODE_FIRST_TO:	return FirstTo::windowMs();
+		case MODE_STREAK:	return Streak::windowMs();
+		case MODE_RAPID:	return RapidFire::windowMs();
+		default:			return Timed::windowMs();
+	}
+}
+
+unsigned int modeBasket(GameRound &g) {
+	switch (gameMode) {
+		case MODE_FIRST_TO:	return FirstTo::basket(g);
+		case MODE_STREAK:	return Streak::basket(g);
+		case MODE_RAPID:	return RapidFire::basket(g);
+		default:			return Timed::basket(g);
+	}
+}
+
+bool modeTick(GameRound &g, uint32_t now) {
+	switch (gameMode) {
+		case MODE_FIRST_TO:	return FirstTo::tick(g, now);
+		case MODE_STREAK:	return Streak::tick(g, now);
+		case MODE_RAPID:	return RapidFire::tick(g, now);
+		default:			return Timed::tick(g, now);
+	}
+}
+
+void modeReport(const GameRound &g) {
+	switch (gameMode) {
+		case MODE_FIRST_TO:	FirstTo::report(g); break;
+		case MODE_STREAK:	Streak::report(g); break;
+		case MODE_RAPID:	RapidFire::report(g); break;
+		default:			Timed::report(g); break;
+	}
+}
+
+//	Takes the mode rather than gameMode: the log ranks rounds of every mode
+bool modeBeats(byte mode, unsigned int best, unsigned int high) {
+	switch (mode) {
+		case MODE_FIRST_TO:	return FirstTo::beats(best, high);
+		case MODE_STREAK:	return Streak::beats(best, high);
+		case MODE_RAPID:	return RapidFire::beats(best, high);
+		default:			return Timed::beats(best, high);
+	}
+}
@@ -0,0 +1,129 @@
+/**********************************************************************************
+ *
+ *	LatencyTrace  --  optional timing of each stage from an input to its outputs
+ *
+ *  File:          LatencyTrace.cpp
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#include	<Arduino.h>
+#include	"LatencyTrace.h"
+
+#ifdef LATENCY_TRACE
+
+#define NotReached	0xFFFF
+#define Saturated	0xFFFE
+#define InMs		0x8000			// set: the rest counts ms, past 131 ms of TraceUnitUs
+
+struct TraceEvent {
+	uint32_t		stamp;				// micros() from the interrupt
+	uint16_t		at[TRACE_STAGES];	// time after stamp, encoded, or NotReached
+};
+
+//	A ring per path, so a long round of baskets keeps the press that started it
+static TraceEvent events[TraceBaskets + TracePresses];
+static const byte ringFirst[TRACE_PATHS] = { 0, TraceBaskets };
+static const byte ringSize[TRACE_PATHS] = { TraceBaskets, TracePresses };
+static byte next[TRACE_PATHS];		// ring slot for the path's next input
+static byte latest[TRACE_PATHS];	// ...and of its open one
+static unsigned int opened[TRACE_PATHS];	// inputs since the last reset, kept or not
+
+static const char pathNames[TRACE_PATHS][7] PROGMEM = { "basket", "button" };
+static const char stageNames[TRACE_STAGES][7] PROGMEM = { "loop", "beep", "spi", "clear" };
+
+static void printP(const char *p) {
+	while (char c = pgm_read_byte(p++)) Serial.print(c);
+}
+
+static byte kept(byte path) {
+	return opened[path] < ringSize[path] ? opened[path] : ringSize[path];
+}
+
+void traceReset() {
+	memset(next, 0, sizeof(next));
+	memset(opened, 0, sizeof(opened));
+}
+
+void traceOpen(byte path, uint32_t stamp) {
+	TraceEvent &e = events[ringFirst[path] + next[path]];
+	e.stamp = stamp;
+	memset(e.at, 0xFF, sizeof(e.at));	// NotReached
+	latest[path] = next[path];
+	next[path] = (next[path] + 1) % ringSize[path];
+	if (opened[path] != 0xFFFF) opened[path]++;
+}
+
+//	16 bits a stage: fine steps for the stages loop() alone delays, ms for
+//	the ones waiting on a lockout or a second of the precount.  The order of
+//	the codes is the order of the times, so they sort as they are
+static uint16_t encode(unsigned long us) {
+	if (us < InMs * (unsigned long)TraceUnitUs) return us / TraceUnitUs;
+	unsigned long ms = us / 1000;
+	return ms < Saturated - InMs ? InMs + ms : Saturated;
+}
+
+static unsigned long decode(uint16_t at) {
+	return (at & InMs) ? (at - InMs) * 1000UL : (unsigned long)at * TraceUnitUs;
+}
+
+//	Only the first time: a later digit write or clear belongs to something else
+void traceMark(byte path, byte stage) {
+	if (opened[path] == 0) return;
+	TraceEvent &e = events[ringFirst[path] + latest[path]];
+	if (e.at[stage] == NotReached) e.at[stage] = encode(micros() - e.stamp);
+}
+
+//	A stage's latencies over the kept inputs of a path, sorted in place
+static byte collect(byte path, byte stage, uint16_t *v) {
+	byte n = 0;
+	for (byte i = 0; i < kept(path); i++) {
+		uint16_t t = events[ringFirst[path] + i].at[stage];
+		if (t == NotReached) continue;
+		byte j = n++;
+		for (; j > 0 && v[j - 1] > t; j--) v[j] = v[j - 1];	// insertion sort: a dozen or so
+		v[j] = t;
+	}
+	return n;
+}
+
+static void printUs(uint16_t at) {
+	Serial.print(' ');
+	if (at == Saturated) Serial.print('>');
+	Serial.print(decode(at));
+}
+
+void traceReport() {
+	uint16_t v[TraceBaskets > TracePresses ? TraceBaskets : TracePresses];
+
+	Serial.println(F("trace  stage   n  p50  p90  max us after the interrupt"));
+	for (byte path = 0; path < TRACE_PATHS; path++) {
+		if (opened[path] == 0) continue;
+		for (byte stage = 0; stage < TRACE_STAGES; stage++) {
+			byte n = collect(path, stage, v);
+			if (n == 0) continue;
+			printP(pathNames[path]);
+			Serial.print(' ');
+			printP(stageNames[stage]);
+			Serial.print(' ');
+			Serial.print(n);
+			printUs(v[(n - 1) / 2]);
+			printUs(v[n * 9 / 10]);
+			printUs(v[n - 1]);
+			Serial.println();
+		}
+		if (kept(path) < opened[path]) {		// the ring wrapped: these are the latest
+			printP(pathNames[path]);
+			Serial.print(F(": last "));
+			Serial.print(kept(path));
+			Serial.print(F(" of "));
+			Serial.println(opened[path]);
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,74 @@
+/**********************************************************************************
+ *
+ *	LoopProfile  --  optional per-section timing of the Scoreboard main loop
+ *
+ *  File:          LoopProfile.cpp
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#include	<Arduino.h>
+#include	"LoopProfile.h"
+
+#ifdef LOOP_PROFILE
+
+struct ProfStats {
+	unsigned long	count;
+	unsigned long	total;			// sum of micros, for the mean
+	unsigned long	minUs;
+	unsigned long	maxUs;
+	unsigned int	bins[PROF_BINS];
+};
+
+static ProfStats prof[PROF_SECTIONS];
+
+static const char profNames[PROF_SECTIONS][8] PROGMEM = {
+	"loop", "clock", "button", "display", "sensor"
+};
+
+void profReset() {
+	memset(prof, 0, sizeof(prof));
+}
+
+void profRecord(byte section, unsigned long elapsed) {
+	ProfStats &s = prof[section];
+	byte bin = 0;
+
+	for (unsigned long lim = 16; bin < PROF_BINS - 1 && elapsed >= lim; lim <<= 1)
+		bin++;
+	if (s.bins[bin] != 0xFFFF) s.bins[bin]++;		// saturate rather than wrap
+	s.count++;
+	s.total += elapsed;
+	if (s.count == 1 || elapsed < s.minUs) s.minUs = elapsed;
+	if (elapsed > s.maxUs) s.maxUs = elapsed;
+}
+
+void profReport() {
+	Serial.println(F("sect     n  min  max mean | <16 <32 <64 <128 <256 <512 <1k >=1k"));
+	for (byte i = 0; i < PROF_SECTIONS; i++) {
+		ProfStats &s = prof[i];
+		if (s.count == 0) continue;
+		for (const char *p = profNames[i]; char c = pgm_read_byte(p); p++)
+			Serial.print(c);
+		Serial.print(' ');
+		Serial.print(s.count);
+		Serial.print(' ');
+		Serial.print(s.minUs);
+		Serial.print(' ');
+		Serial.print(s.maxUs);
+		Serial.print(' ');
+		Serial.print(s.total / s.count);
+		Serial.print(F(" |"));
+		for (byte b = 0; b < PROF_BINS; b++) {
+			Serial.print(' ');
+			Serial.print(s.bins[b]);
+		}
+		Serial.println();
+	}
+}
+
+#endif
@@ -0,0 +1,64 @@
+/**********************************************************************************
+ *
+ *	Power  --  low-power idle between rounds
+ *
+ *  File:          Power.cpp
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#include	<Arduino.h>
+#include	"Display.h"
+#include	"Sensor.h"
+#include	"Power.h"
+#include	"Recovery.h"
+
+#if defined(__AVR__)
+#include	<avr/sleep.h>
+
+static byte wakeInt;
+
+//	Level interrupt keeps firing while the button is held, so disarm at once
+static void wakeUp() {
+	detachInterrupt(wakeInt);
+}
+#else
+#include	"NativeHost.h"
+#endif
+
+unsigned long sleepUntilButton(byte buttonPin) {
+	displayPower(false);
+	sensorStandby();
+	Serial.flush();							// let the last report finish sending
+	watchdogStop();							// it would end the sleep with a reset
+
+#if defined(__AVR__)
+	byte adc = ADCSRA;
+	ADCSRA = 0;								// ADC off: it would draw in power-down
+
+	set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+	noInterrupts();
+	sleep_enable();
+	// only a LOW level on INT0/INT1 can wake the part from power-down
+	wakeInt = digitalPinToInterrupt(buttonPin);
+	attachInterrupt(wakeInt, wakeUp, LOW);
+	sleep_bod_disable();
+	interrupts();
+	sleep_cpu();							// ...until the button is pressed
+	sleep_disable();
+	ADCSRA = adc;
+#else
+	(void)buttonPin;
+	native::powerDown();					// the host wakes at once, as if pressed
+#endif
+
+	uint32_t woke = micros();
+	sensorResume();
+	displayPower(true);
+	watchdogBegin();
+	return micros() - woke;
+}
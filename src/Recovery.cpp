@@ -0,0 +1,135 @@
+/**********************************************************************************
+ *
+ *	Recovery  --  watchdog, round checkpoint and fault counts
+ *
+ *  File:          Recovery.cpp
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#include	<Arduino.h>
+#include	<stddef.h>
+#include	"Calibration.h"		//  crc16()
+#include	"Recovery.h"
+
+#if defined(__AVR__)
+#include	<avr/wdt.h>
+#define NoInit	__attribute__((section(".noinit")))	// left as it was by a reset
+#else
+#include	"NativeHost.h"
+#define NoInit
+#endif
+
+#define StallMark	0xA5
+
+//	Everything that must outlive a warm reset, sealed as a whole
+struct Saved {
+	Checkpoint		cp;
+	bool			inRound;	// cp holds a round in play
+	unsigned int	faults[FaultKinds];
+	uint16_t		crc;		// CRC-16/CCITT of the fields above
+};
+
+static_assert(sizeof(Saved) < 256, "crc16() takes a byte count");
+
+static Saved saved NoInit;
+static volatile byte stalled NoInit;	// StallMark once the watchdog interrupt has run
+
+static uint16_t savedCrc() {
+	return crc16((const byte *)&saved, offsetof(Saved, crc));
+}
+
+static inline void seal() {
+	saved.crc = savedCrc();
+}
+
+#if defined(__AVR__)
+
+//	A watchdog reset leaves the watchdog running at its shortest period; stop
+//	it before the C runtime and setup() can overrun that
+void wdtOffAtBoot() __attribute__((naked, used, section(".init3")));
+void wdtOffAtBoot() {
+	MCUSR = 0;
+	wdt_disable();
+}
+
+//	First period without a kick: note it, and let the second one reset the part
+ISR(WDT_vect) {
+	stalled = StallMark;
+}
+
+void watchdogBegin() {
+	wdt_enable(WDTO_250MS);					// WatchdogMs
+	WDTCSR |= _BV(WDIE);					// interrupt first, reset on the next period
+}
+
+void watchdogKick() {
+	wdt_reset();
+	if (stalled == StallMark) {				// loop() came back in time: count it, re-arm
+		stalled = 0;
+		faultNote(FaultStall);
+		WDTCSR |= _BV(WDIE);
+	}
+}
+
+void watchdogStop() {
+	wdt_disable();
+}
+
+#else	// host build: no reset, but the shims time each wait for a kick
+
+void watchdogBegin()	{ native::wdtRun(true); }
+void watchdogKick()		{ native::wdtKick(); }
+void watchdogStop()		{ native::wdtRun(false); }
+
+#endif
+
+//	At boot: keep the fault counts over a warm reset, count the stall that
+//	caused it, and hand back a round that was in play
+bool checkpointLoad(Checkpoint &cp) {
+	if (saved.crc != savedCrc()) {			// power-up: RAM holds nothing of ours
+		memset(&saved, 0, sizeof(saved));
+		stalled = 0;
+	}
+	if (stalled == StallMark) {
+		stalled = 0;
+		if (saved.faults[FaultStall] != 0xFFFF) saved.faults[FaultStall]++;
+	}
+	bool resume = saved.inRound;
+	if (resume) {
+		cp = saved.cp;
+		if (saved.faults[FaultResume] != 0xFFFF) saved.faults[FaultResume]++;
+	}
+	seal();
+	return resume;
+}
+
+void checkpointSave(const Checkpoint &cp) {
+	saved.cp = cp;
+	saved.inRound = true;
+	seal();
+}
+
+void checkpointClear() {
+	saved.inRound = false;
+	seal();
+}
+
+void faultNote(byte kind) {
+	if (saved.faults[kind] != 0xFFFF) saved.faults[kind]++;
+	seal();
+}
+
+unsigned int faultCount(byte kind) {
+	return saved.faults[kind];
+}
+
+unsigned int faultTotal() {
+	unsigned long n = 0;
+	for (byte k = 0; k < FaultKinds; k++) n += saved.faults[k];
+	return n > 0xFFFF ? 0xFFFF : n;
+}
@@ -0,0 +1,166 @@
+/**********************************************************************************
+ *
+ *	Scheduler  --  timer-ticked cooperative task scheduler
+ *
+ *  File:          Scheduler.cpp
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#include	<Arduino.h>
+#include	"Scheduler.h"
+
+#if defined(__AVR__)
+#include	<avr/sleep.h>
+#endif
+
+struct Task {
+	TaskFn			run;
+	unsigned int	period;			// ms
+	unsigned int	due;			// tick at which it should next run
+	unsigned int	runs;
+	unsigned int	maxLate;		// ms
+	unsigned int	misses;			// ran a full period or more late
+};
+
+static Task tasks[SchedMaxTasks];
+static byte taskCount = 0;
+static TaskFn hooks[SchedMaxHooks];
+static volatile byte hookCount = 0;
+
+static inline void runHooks() {
+	for (byte i = 0; i < hookCount; i++)
+		hooks[i]();
+}
+
+#if defined(__AVR__)
+
+static volatile unsigned int ticks = 0;
+
+ISR(TIMER1_COMPA_vect) {
+	ticks++;
+	runHooks();
+}
+
+void schedBegin() {
+	noInterrupts();
+	TCCR1A = 0;
+	TCCR1B = _BV(WGM12) | _BV(CS11) | _BV(CS10);	// CTC, clk/64 = 250 kHz
+	OCR1A = (F_CPU / 64 / SchedTickHz) - 1;
+	TCNT1 = 0;
+	TIMSK1 = _BV(OCIE1A);
+	interrupts();
+}
+
+unsigned int schedTicks() {
+	noInterrupts();
+	unsigned int t = ticks;
+	interrupts();
+	return t;
+}
+
+static inline void idle() {
+	set_sleep_mode(SLEEP_MODE_IDLE);				// timers, TWI, USART keep running
+	sleep_mode();									// woken by the next interrupt
+}
+
+#else	// host build: the tick follows the virtual millis() clock
+
+static unsigned int ticks = 0;
+static uint32_t tickedTo;			// millis() the ticks have caught up with
+static bool ticking = false;			// as the timer, stopped until schedBegin()
+
+void schedBegin() {
+	tickedTo = millis();
+	ticking = true;
+}
+
+//	Replay the interrupt for every virtual millisecond that has passed
+unsigned int schedTicks() {
+	while (ticking && tickedTo != millis()) {
+		tickedTo++;
+		ticks++;
+		runHooks();
+	}
+	return ticks;
+}
+
+static inline void idle()	{}
+
+#endif
+
+bool schedOnTick(TaskFn fn) {
+	if (hookCount >= SchedMaxHooks) return false;
+	hooks[hookCount] = fn;
+	hookCount++;						// publish only after the slot is written
+	return true;
+}
+
+byte schedAdd(TaskFn fn, unsigned int periodMs) {
+	if (taskCount >= SchedMaxTasks) return 0xFF;
+	Task &t = tasks[taskCount];
+	t.run = fn;
+	t.period = periodMs;
+	t.due = schedTicks();
+	t.runs = t.maxLate = t.misses = 0;
+	return taskCount++;
+}
+
+void schedRun(bool mayIdle) {
+	bool ran = false;
+
+	for (byte i = 0; i < taskCount; i++) {
+		Task &t = tasks[i];
+		unsigned int now = schedTicks();
+		unsigned int late = now - t.due;
+		if ((int)late < 0) continue;				// not yet due
+
+		if (late > t.maxLate) t.maxLate = late;
+		if (late >= t.period) {
+			t.misses++;
+			t.due = now;							// skip the missed periods, don't burst
+		}
+		t.due += t.period;
+		t.runs++;
+		t.run();
+		ran = true;
+	}
+	if (!ran && mayIdle) idle();
+}
+
+unsigned int schedMisses() {
+	unsigned int n = 0;
+	for (byte i = 0; i < taskCount; i++) n += tasks[i].misses;
+	return n;
+}
+
+unsigned int schedMaxLate() {
+	unsigned int n = 0;
+	for (byte i = 0; i < taskCount; i++)
+		if (tasks[i].maxLate > n) n = tasks[i].maxLate;
+	return n;
+}
+
+void schedReport() {
+	Serial.println(F("task period runs late misses"));
+	for (byte i = 0; i < taskCount; i++) {
+		Serial.print(i);
+		Serial.print(' ');
+		Serial.print(tasks[i].period);
+		Serial.print(' ');
+		Serial.print(tasks[i].runs);
+		Serial.print(' ');
+		Serial.print(tasks[i].maxLate);
+		Serial.print(' ');
+		Serial.println(tasks[i].misses);
+	}
+}
+
+void schedResetStats() {
+	for (byte i = 0; i < taskCount; i++)
+		tasks[i].runs = tasks[i].maxLate = tasks[i].misses = 0;
+}
@@ -29,251 +29,493 @@
 */
 #include 	<Arduino.h>
 #include 	<Wire.h>
-#include	"ezBuzzer.h" 		// ezBuzzer library
-#include	"CountDown.h"		//  countdown timer library
-#include 	<DFRobot_VL6180X.h> //  ranging ToF sensor
-#include 	"LedControl_HW_SPI.h"
-#include	"LedControl.h"		//  Digit-segment driver
+#include	"Config.h"			//  game settings and their compile-time checks
+#include	"Display.h"			//  framebuffered digit-segment driver
+#include	"Sensor.h"			//  VL6180X hoop detector, timestamped detections
+#include	"TwiQueue.h"		//  background I2C transactions
+#include	"Scheduler.h"		//  1 ms timer tick and periodic tasks
+#include	"GameClock.h"		//  shot clock counted down in the tick interrupt
+#include	"Power.h"			//  power-down between rounds
+#include	"Button.h"			//  debounced start button gestures
+#include	"Buzzer.h"			//  Timer2 tone engine
+#include	"GameMode.h"		//  rules of each game mode
+#include	"SessionLog.h"		//  round history in EEPROM
+#include	"Telemetry.h"		//  binary records over Serial (-D TELEMETRY)
+#include	"LoopProfile.h"		//  optional loop() section timing (-D LOOP_PROFILE)
+#include	"LatencyTrace.h"	//  optional input-to-output stage timing (-D LATENCY_TRACE)
+#include	"Recovery.h"		//  watchdog, round checkpoint, fault counts
 
 
 
 #define LAUNCHCOUNT 0			// sound countdown to start of shot timer
 #define BASKET 	1				// sound when score detected
 #define TIMESUP 2				// sound end of shooting window
-#define BounceInterval	15		// millsecs to allow for contact or detector bounce
-#define	ShotClock  30			// 30 sec shot window 
-#define	Precount	5			//    ...plus 5sec count-in
-#define	Fullcount  35			//	Clock start setting
-#define SCOREDISP  0			// 	Select the score display digits
-#define	CLOCKDISP  1			//  Select the timer display digits
-#define VL6180X_ADDRESS 0x29
-
-const int BUTTON_PIN = 2;
-const int BUZZER_PIN = 5;
-const int trigPin = 3;			//distance sensor pin
-const int driverAddr = 0;		// address of MAX7219 display driver
-const int dispPin = 10;			// pin to select MAX7219 display controller
-const unsigned long timeoutLimit = 300000;	// 5 min (in millisecs) timeout to shut down display
-
-DFRobot_VL6180X VL6180X;
-ezBuzzer buzzer(BUZZER_PIN); // create ezBuzzer object that attaches to a pin;
-CountDown cdt;  			//  default millis
-
-/*
- Now we need a LedControl to work with.
- ***** These pin numbers will probably not work with your hardware *****
- pin 12 is connected to the DataIn 
- pin 11 is connected to the CLK 
- pin 10 is connected to LOAD 
- We have only a single MAX72XX.
- */
-LedControl_HW_SPI lc = LedControl_HW_SPI();
-
-volatile unsigned int contactBounceTime;		// Supports debouncing of pushbutton time
-volatile bool event = false;			// distance sensor triggered  event
-
-// notes in the melody:
-int melody[] = {
-  NOTE_E5, NOTE_E4, NOTE_C4, NOTE_G4,
-  NOTE_E5, NOTE_A5
-};
-// note durations: 4 = quarter note, 8 = eighth note, etc, also called tempo:
-int noteDurations[] = {
-	8, 8, 8, 2, 
-	8, 1
+#define SensorPeriod	1		// task periods in millisecs
+#define ButtonPeriod	1		// edges are stamped by the ISR; this only bounds start latency
+#define ClockPeriod		1		// acts on shot clock expiry within the tick
+#define LogPeriod		1		// EEPROM takes a byte every 3.3 ms; this just keeps up
+#define ModeShowMs		2000	// millisecs "P<n>" stays up after changing mode
+
+
+//	Sounds, in flash: eighth notes 125 ms, half 500, whole 1000, each with a 30% gap
+static const Note launchBeep[] PROGMEM = { { Pitch(NOTE_BEEP), Ms(400) }, SoundEnd };
+static const Note basketBeep[] PROGMEM = { { Pitch(NOTE_BEEP), Ms(200) }, SoundEnd };
+static const Note timesUp[] PROGMEM = {
+	{ Pitch(NOTE_E5), Ms(125) }, { Rest, Ms(40) },
+	{ Pitch(NOTE_E4), Ms(125) }, { Rest, Ms(40) },
+	{ Pitch(NOTE_C4), Ms(125) }, { Rest, Ms(40) },
+	{ Pitch(NOTE_G4), Ms(500) }, { Rest, Ms(150) },
+	{ Pitch(NOTE_E5), Ms(125) }, { Rest, Ms(40) },
+	{ Pitch(NOTE_A5), Ms(1000) },
+	SoundEnd
 };
 
-int lastButtonState = HIGH; 	// the previous state from the input pin
+static const byte highText[] PROGMEM = { SegH, SegI };	// scrolled for a new high score
+
 bool shooting = false;			// is shooting in progress?
 int	 remSecs	=	0;			// time remaining with seconds resolution
+unsigned int remMs = 0;			// time remaining in millisecs
 int	 preCount = 0;				// register for count during pre-shooting count
-int	 currentBtnState;			// tracks state of trigger button
-int  soundType = 0;
-int	 loopcount = 0;
-int  scoreCount = 0;							// current score total
-unsigned long displayTimeout = 0;
+GameRound game[Lanes];			// this round's baskets and mode score, per lane
+uint32_t modeShownUntil = 0;	// millis() until which the clock digits show the mode
+uint32_t displayTimeout = 0;
+bool lockedOut[Lanes];			// basket refractory window in progress?
+uint32_t firstShotTime[Lanes];	// micros() of the first basket this round
+uint32_t fastestShot[Lanes];	// shortest shot-to-shot interval this round (micros)
+#if Lanes > 1
+uint32_t laneEnd[Lanes];	// micros() each lane's shot clock runs out; the shared clock
+								// runs to the latest, as rapid fire restarts them apart
+#endif
 
 
-//	ISR handler for ball detected through hoop
-//  only triggered if shooting == true
-void isr_scoreIt(){
-	event = true;
-}
-
 //	Routine to sound out alerts for each event occurrence
 void soundIt(int eventType) {
 
-	int length = sizeof(noteDurations) / sizeof(int);
-
 	switch (eventType) {
 		case LAUNCHCOUNT:			// Get Ready beeps
-			buzzer.beep(400);
+			buzzerPlay(launchBeep, SND_QUEUE);
+			TRACE_MARK(TRACE_BUTTON, TRACE_BEEP);	// the first one starts at once: nothing plays
 			break;
 		case BASKET:				// score detected
-			buzzer.beep(200);	//  single beep for Score!
+			buzzerPlay(basketBeep, SND_NOW);	//  single beep for Score! cuts in at once
+			TRACE_MARK(TRACE_BASKET, TRACE_BEEP);
 			break;
 		case TIMESUP:			//  shooting window over
-			buzzer.playMelody(melody, noteDurations, length);	// melody signals end
+			buzzerStop();
+			buzzerPlay(timesUp, SND_NOW);		// melody signals end
 			break;
 		default:
-			Serial.println("Buzzer case switch fail!");
+			Serial.println(F("Buzzer case switch fail!"));
+	}
+}
+
+//	Restart a lane's shot clock for a mode that asks for it
+void restartClock(byte lane, unsigned int window) {
+#if Lanes > 1
+	laneEnd[lane] = micros() + window * 1000UL;
+	if (window < clockRemaining()) return;	// another lane's clock runs longer
+#else
+	(void)lane;
+#endif
+	clockStart(window);
+}
+
+//	The lane's own shot clock has run out (only rapid fire moves it off the shared one)
+bool laneOver(byte lane, uint32_t at) {
+#if Lanes > 1
+	return (int32_t)(at - laneEnd[lane]) >= 0;
+#else
+	(void)lane; (void)at;
+	return false;
+#endif
+}
+
+//	Millisecs left on a lane's shot clock
+unsigned int laneRemaining(byte lane) {
+#if Lanes > 1
+	if (shooting) {
+		int32_t left = (int32_t)(laneEnd[lane] - micros());
+		if (left <= 0) return 0;
+		if ((uint32_t)left / 1000 < remMs) return (left + 999) / 1000;
+	}
+#else
+	(void)lane;
+#endif
+	return remMs;
+}
+
+//	Count a basket detected at shotTime (micros) and track shot-to-shot intervals.
+//	The session log and telemetry follow lane 0
+void scoreIt(byte lane, uint32_t shotTime) {
+	GameRound &g = game[lane];
+	if (g.baskets == 0) {
+		firstShotTime[lane] = shotTime;
+	} else if (fastestShot[lane] == 0 || (shotTime - g.lastBasket) < fastestShot[lane]) {
+		fastestShot[lane] = shotTime - g.lastBasket;
+	}
+	g.baskets += 1;
+	g.lastBasket = shotTime;		// also starts the refractory window
+	if (lane == 0) {
+		TRACE_OPEN(TRACE_BASKET, shotTime);
+		TRACE_MARK(TRACE_BASKET, TRACE_LOOP);
+		logShot(shotTime - g.started);
+	}
+	unsigned int window = modeBasket(g);
+	if (window) restartClock(lane, window);	// mode restarts the shot clock
+	if (lane == 0) tlmShot(shotTime, g.baskets, g.score);
+	soundIt(BASKET);
+	displayFlash(lane);
+	lockedOut[lane] = true;			// start refractory window; loop keeps running
+}
+
+//	End of round summary over Serial: a line per lane, then one for the whole board
+void reportRound() {
+	for (byte lane = 0; lane < Lanes; lane++) {
+		const GameRound &g = game[lane];
+		if (Lanes > 1) {
+			Serial.print(F("Lane "));
+			Serial.print(lane + 1);
+			Serial.print(F(": "));
+		}
+		Serial.print(F("Score "));
+		Serial.print(g.baskets);
+		if (g.baskets > 1) {
+			Serial.print(F(", fastest "));
+			Serial.print(fastestShot[lane] / 1000);
+			Serial.print(F(" ms, mean "));
+			Serial.print((g.lastBasket - firstShotTime[lane]) / 1000 / (g.baskets - 1));
+			Serial.print(F(" ms"));
+		}
+		Serial.println();
+		modeReport(g);
+	}
+	Serial.print(F("Dropped "));
+	Serial.print(sensorDropped());
+	Serial.print(F(", task misses "));
+	Serial.print(schedMisses());
+	Serial.print(F(", max late "));
+	Serial.print(schedMaxLate());
+	Serial.print(F(" ms, display queue "));
+	Serial.print(displayQueuePeak());
+	Serial.print(F(", faults "));
+	Serial.println(faultTotal());
+#if SensorMode == SENSOR_HIGHRATE
+	Serial.print(F("Sensor "));
+	Serial.print(sensorSampleRate());
+	Serial.println(F(" samples/s"));
+#endif
+}
+
+//	Count detections waiting in each lane's ring; none after the shot clock expired
+void countBaskets() {
+	uint32_t shotTime, endTime;
+	bool ended = clockEnded(endTime);
+
+	sensorService();						// high-rate mode: read samples, detect passes
+	for (byte lane = 0; lane < Lanes; lane++) {
+		while (hoopEvents[lane].pop(shotTime)) {	// hoop detected
+			if (ended && (int32_t)(shotTime - endTime) >= 0) continue;
+			if ((int32_t)(shotTime - game[lane].started) < 0) continue;	// read in before the flush
+			if (laneOver(lane, shotTime)) continue;
+			// ignore retriggers while the ball is still passing through
+			if (!lockedOut[lane] || (shotTime - game[lane].lastBasket) >= Config.basketLockoutMs * 1000UL)
+				scoreIt(lane, shotTime);
+		}
+	}
+}
+
+//	Task: bring up the sensors, count detected baskets, end the refractory windows
+void taskSensor() {
+	PROF_BEGIN(PROF_SENSOR);
+	sensorPoll();							// brings up a missing sensor in the background
+	if (shooting) {
+		countBaskets();
+		for (byte lane = 0; lane < Lanes; lane++) {
+			if (lockedOut[lane] && (micros() - game[lane].lastBasket) >= Config.basketLockoutMs * 1000UL) {
+				lockedOut[lane] = false;	// re-arm the sensor once the window has passed
+				sensorRearm(lane);
+			}
+		}
+	}
+	PROF_END(PROF_SENSOR);
+}
+
+//	Abandon the precount or shot clock without a summary
+void cancelRound() {
+	shooting = false;
+	clockStop();
+	checkpointClear();
+	remSecs = 0;
+	displayTimeout = millis();
+	tlmState(TlmCancelled, gameMode, 0);
+	Serial.println(F("Round cancelled"));
+}
+
+//	Single-letter commands from the serial monitor, taken only while idle
+void serialCommand(int cmd) {
+	switch (cmd) {
+		case 'd':	logDump(); break;		// round history, streamed by taskLog
+		case 'p':	PROF_REPORT(); break;	// loop timings in LOOP_PROFILE builds
+		case 't':	TRACE_REPORT(); break;	// stage latencies in LATENCY_TRACE builds
 	}
 }
 
-//	Routine to display 2 digits for either Score count or Countdown timer
-//       dispType = SCOREDISP (=0) or CLOCKDISP (=1)
-//
-void displayIt(int dispType, int numToDisp) {
-
-	const bool decPt = false;	// never light up the decimal point
-	static byte	tens[2], units[2];		// hold the digit values for display (score & counter)
-	byte newUnits, newTens;		// from incoming numToDisp
-	int	remToDisp;				// stipped of units value
-	int digOffset;				// digits for countdown clock are displayed on score address + 2
-
-	newUnits = numToDisp % 10;		// extract units value
-	remToDisp = numToDisp / 10;
-	newTens =  remToDisp % 10 ;		// extract tens value
-	digOffset = 2 * dispType;		//  0 address offset for Score display, 2 for Countdown display
-
-	if (units[dispType] != newUnits) {				// units is displayed on digits 0 & 2
-		units[dispType] = newUnits;					// update units digit register
-		lc.setDigit(driverAddr,0+digOffset,units[dispType],decPt);	// display new units value
+//	Task: act on button gestures and time out the display while idle
+void taskButton() {
+	uint32_t pressTime;
+
+	PROF_BEGIN(PROF_BUTTON);
+	byte gesture = buttonRead(pressTime);
+	PROF_END(PROF_BUTTON);
+	if (gesture == BTN_LONG) {
+		if (shooting) {
+			cancelRound();					// long press stops a round in play
+			return;
+		}
+		if (clockRunning()) {				// the same press started a precount: drop it
+			clockStop();
+			buzzerStop();
+			remSecs = 0;
+		}
+		gameMode = (gameMode + 1) % MODE_COUNT;
+		modeShownUntil = millis() + ModeShowMs;
+		tlmState(TlmIdle, gameMode, 0);
+		displayTimeout = millis();
+		return;
 	}
+	if (shooting) return;					// Push button etc. is diabled while on shot clock
+
+	if ((gesture == BTN_PRESS || gesture == BTN_DOUBLE) && sensorReady()) {
+		TRACE_OPEN(TRACE_BUTTON, pressTime);
+		TRACE_MARK(TRACE_BUTTON, TRACE_LOOP);
+		unsigned int roundMs = Config.precountSecs * 1000U + modeWindowMs();
+		remSecs	=	(roundMs + 999) / 1000;
+		preCount = remSecs;
+		for (byte lane = 0; lane < Lanes; lane++) {
+			game[lane] = GameRound();
+			fastestShot[lane] = 0;
+		}
+		logNewRound();
+		displayStopEffects();			// the precount shows at once
+		modeShownUntil = millis();
+		displayPower(true);				//  make shure display is awake
+		displayTimeout = millis();		//  renew display timer
+		clockStart(roundMs);			// start countdown clock in millisecs
+		tlmState(TlmPrecount, gameMode, roundMs);
+	} 
+	else if ((millis() - displayTimeout) > Config.idleTimeoutMs) {
+		tlmState(TlmSleep, gameMode, 0);
+		unsigned long wakeTime = sleepUntilButton(Config.buttonPin);	// returns once pressed
+		tlmState(TlmWake, gameMode, 0);
+		Serial.print(F("Wake to ready us: "));
+		Serial.println(wakeTime);
+		displayTimeout = millis();
+		buttonResume();					// the waking press is reported as BTN_PRESS
+	}
+	if (Serial.available()) serialCommand(Serial.read());
+}
+
+//	Stop shooting, sound the end and report
+void endRound() {
+	shooting = false;
+	soundIt(TIMESUP);
+	clockStop();
+	checkpointClear();				// at once: a reset now must not replay the round
+	tlmState(TlmEnded, gameMode, 0);
+	displayTimeout = millis();		// record current time to start display timeout
+	for (byte lane = 0; lane < Lanes; lane++)
+		if (modeBeats(gameMode, game[lane].best, logHighScore(gameMode)))	// before this round is counted in
+			displayScroll(highText, sizeof(highText), lane);
+	logRound(gameMode, game[0].baskets, game[0].best);	// written by taskLog, after the buzzer
+	reportRound();
+	PROF_ROUND_END();				// report this round's timings
+	TRACE_ROUND_END();				// ...and stage latencies
+}
+
+//	Every lane's mode rules each tick; any one of them can end the round
+//	(in first-to, the first lane to the target)
+bool modeTicks(uint32_t now) {
+	bool over = false;
+	for (byte lane = 0; lane < Lanes; lane++)
+		over |= modeTick(game[lane], now);
+	return over;
+}
 
-	if (tens[dispType] != newTens) {
-		tens[dispType] = newTens;							//  tens displayed on digits 1 & 3
-		lc.setDigit(driverAddr,1+digOffset,tens[dispType],decPt);	// and again for tens digit
+//	Task: run the countdown through precount, shot clock and end of round
+void taskClock() {
+	uint32_t endTime;
+
+	PROF_BEGIN(PROF_CLOCK);
+	remMs = clockRemaining();
+	remSecs = (remMs + 999) / 1000;			// whole seconds round up, 35 down to 1
+	PROF_END(PROF_CLOCK);
+
+	if (shooting) {
+		if (clockEnded(endTime)) {			// timer has expired
+			countBaskets();					// those detected before expiry still count
+			if (!clockEnded(endTime)) return;	// ...and one of them restarted the clock
+			endRound();
+		} else if (modeTicks(micros())) {
+			countBaskets();
+			endRound();						// mode's own finish, e.g. target reached
+		}
+	} else if (remMs != 0) {				// clock has started
+		if (remMs <= modeWindowMs()) {
+			shooting = true;
+			for (byte lane = 0; lane < Lanes; lane++) {
+				game[lane].started = micros();
+				lockedOut[lane] = false;
+#if Lanes > 1
+				laneEnd[lane] = micros() + remMs * 1000UL;
+#endif
+			}
+			tlmState(TlmShooting, gameMode, remMs);
+			sensorService();				// discard anything detected before the shot clock
+			sensorFlush();
+			sensorRearm();
+			sensorResetStats();
+			schedResetStats();
+			displayResetStats();
+		}
+		else if (preCount > remSecs){
+			soundIt(LAUNCHCOUNT);				// in pre-count phase
+			preCount = remSecs;
+		} 
 	}
+}
+
+//	Task: keep the round in play resumable after a warm reset; a round dropped
+//	any other way (a mode change in the precount) is cleared here
+void taskCheckpoint() {
+	static bool saved = false;
 
+	if (!clockRunning()) {
+		if (saved) checkpointClear();
+		saved = false;
+		return;
+	}
+	Checkpoint cp;
+	uint32_t now = micros();
+	cp.mode = gameMode;
+	cp.shooting = shooting;
+	cp.clockMs = clockRemaining();
+	cp.shotMs = shooting ? (now - game[0].started) / 1000 : 0;
+	for (byte lane = 0; lane < Lanes; lane++) {
+		const GameRound &g = game[lane];
+		LaneCheckpoint &l = cp.lane[lane];
+		l.baskets = g.baskets;
+		l.score = g.score;
+		l.best = g.best;
+		l.lastMs = g.baskets ? (g.lastBasket - g.started) / 1000 : 0;
+		l.leftMs = laneRemaining(lane);
+	}
+	checkpointSave(cp);
+	saved = true;
+}
+
+//	Carry on a round a warm reset cut short, from its last checkpoint.  The
+//	time loop() was stopped is given back; shot times before the reset are
+//	not logged and the summary's fastest and mean start again
+void resumeRound(const Checkpoint &cp) {
+	uint32_t now = micros();
+
+	gameMode = cp.mode < MODE_COUNT ? cp.mode : MODE_TIMED;
+	shooting = cp.shooting;
+	for (byte lane = 0; lane < Lanes; lane++) {
+		GameRound &g = game[lane];
+		const LaneCheckpoint &l = cp.lane[lane];
+		g.baskets = l.baskets;
+		g.score = l.score;
+		g.best = l.best;
+		g.started = now - cp.shotMs * 1000UL;
+		g.lastBasket = g.started + l.lastMs * 1000UL;
+		firstShotTime[lane] = g.started;
+		fastestShot[lane] = 0;
+		lockedOut[lane] = false;
+#if Lanes > 1
+		laneEnd[lane] = now + l.leftMs * 1000UL;
+#endif
+	}
+	remMs = cp.clockMs;
+	remSecs = (remMs + 999) / 1000;
+	preCount = remSecs;
+	logNewRound();
+	displayTimeout = millis();
+	clockStart(cp.clockMs);
+	tlmState(shooting ? TlmShooting : TlmPrecount, gameMode, remMs);
+	Serial.println(F("Round resumed after a reset"));
+}
+
+//	Task: write the last round to EEPROM and stream dumps, never while shooting
+//	and only once the buzzer is quiet, so the writes follow the time-up melody
+void taskLog() {
+	if (!shooting && !buzzerBusy()) logService();
+}
+
+//	Task: stage each lane's score and clock, then send whatever changed as one frame
+void taskDisplay() {
+	PROF_BEGIN(PROF_DISPLAY);
+	bool modeShown = remMs == 0 && (int32_t)(millis() - modeShownUntil) < 0;
+	displayFade(!shooting && (millis() - displayTimeout) > Config.idleTimeoutMs - Config.sleepFadeMs);
+	for (byte lane = 0; lane < Lanes; lane++) {
+		unsigned int ms = laneRemaining(lane);
+		displayPulse(shooting && ms < Config.pulseBelowMs ? ms : 0, lane);
+		displayIt(SCOREDISP, game[lane].score, lane);
+		if (!sensorReady(lane))
+			displayError(CLOCKDISP, ErrNoSensor, lane);	// no play until the sensor answers
+		else if (modeShown)
+			displayMode(CLOCKDISP, gameMode + 1, lane);	// "P1".."P4" just after a change
+		else if (shooting && ms < Config.tenthsBelowMs)
+			displayTenths(CLOCKDISP, ms / 100, lane);	// "9.8" for the final seconds
+		else
+			displayIt(CLOCKDISP, (ms + 999) / 1000, lane);
+	}
+	displayFlush();
+	PROF_END(PROF_DISPLAY);
 }
 
 void setup() {
+	Checkpoint cp;
+	bool resume = checkpointLoad(cp);		// a warm reset in the middle of a round?
+
 	Serial.begin(115200);
 	Wire.begin(); //Start I2C library
+	Wire.setClock(400000);		// VL6180X supports fast mode
+	Wire.setWireTimeout(WireTimeout, true);	// a hung bus fails the call instead of stalling
     pinMode (LED_BUILTIN,OUTPUT);
-  	pinMode(BUTTON_PIN, INPUT_PULLUP);
+  	buttonBegin(Config.buttonPin);
 	
-	soundType = 0;
-	scoreCount = 0;
+	for (byte lane = 0; lane < Lanes; lane++)
+		game[lane] = GameRound();
 	displayTimeout = millis();
-	cdt.stop();
+	modeShownUntil = millis();	// not since 0: millis() need not start there
+	clockStop();
 	shooting = false;
 
-	while(!(VL6180X.begin())){
-    	Serial.println("Please check that the IIC device is properly connected!");
-    	delay(1000);
-  	}  
- 	 /** Enable the notification function of the INT pin
- 	  * mode：
- 	  * VL6180X_DIS_INTERRUPT          Not enable interrupt
- 	  * VL6180X_LOW_INTERRUPT          Enable interrupt, by default the INT pin outputs low level
-  	 * VL6180X_HIGH_INTERRUPT         Enable interrupt, by default the INT pin outputs high level
- 	  * Note: When using the VL6180X_LOW_INTERRUPT mode to enable the interrupt, please use "RISING" to trigger it.
- 	  *       When using the VL6180X_HIGH_INTERRUPT mode to enable the interrupt, please use "FALLING" to trigger it.
- 	  */
- 	VL6180X.setInterrupt(/*mode*/VL6180X_HIGH_INTERRUPT); 
-
-  	/** Set the interrupt mode for collecting ambient light
-  	 * mode 
-  	 * interrupt disable  :                       VL6180X_INT_DISABLE             0
-  	 * value < thresh_low :                       VL6180X_LEVEL_LOW               1 
-  	 * value > thresh_high:                       VL6180X_LEVEL_HIGH              2
-  	 * value < thresh_low OR value > thresh_high: VL6180X_OUT_OF_WINDOW           3
-  	 * new sample ready   :                       VL6180X_NEW_SAMPLE_READY        4
-  	 */
-  	VL6180X.rangeConfigInterrupt(VL6180X_OUT_OF_WINDOW);
-
-  	/*Set the range measurement period*/
-  	VL6180X.rangeSetInterMeasurementPeriod(/* periodMs 0-25500ms */200);
-
-  	/*Set threshold value*/
-  	VL6180X.setRangeThresholdValue(/*thresholdL 0-255mm */120,/*thresholdH 0-255mm*/255);
-
-  	#if defined(ESP32) || defined(ESP8266)||defined(ARDUINO_SAM_ZERO)
-  	attachInterrupt(digitalPinToInterrupt(D9)/*Query the interrupt number of the D9 pin*/,interrupt,FALLING);
-  	#else
- 	 /*    The Correspondence Table of AVR Series Arduino Interrupt Pins And Terminal Numbers
-  	 * ---------------------------------------------------------------------------------------
-  	 * |                                        |  DigitalPin  | 2  | 3  |                   |
-  	 * |    Uno, Nano, Mini, other 328-based    |--------------------------------------------|
-  	 * |                                        | Interrupt No | 0  | 1  |                   |
- 	 * |-------------------------------------------------------------------------------------|
-   	* |                                        |    Pin       | 2  | 3  | 21 | 20 | 19 | 18 |
-   	* |               Mega2560                 |--------------------------------------------|
-   	* |                                        | Interrupt No | 0  | 1  | 2  | 3  | 4  | 5  |
-   	* |-------------------------------------------------------------------------------------|
-   	* |                                        |    Pin       | 3  | 2  | 0  | 1  | 7  |    |
-   	* |    Leonardo, other 32u4-based          |--------------------------------------------|
-   	* |                                        | Interrupt No | 0  | 1  | 2  | 3  | 4  |    |
-   	* |--------------------------------------------------------------------------------------
-   */
-  
-  	attachInterrupt(/*Interrupt No*/1,isr_scoreIt,FALLING);	//Enable the external interrupt 1, connect INT1/2 to the digital pin of the main control: 
-    //UNO(2), Mega2560(2), Leonardo(3), microbit(P0).
-  	#endif
-
-  	/*Start continuous range measuring mode */
-  	VL6180X.rangeStartContinuousMode();
-
-	/*
-   	The MAX72XX is in power-saving mode on startup,
-   	we have to do a wakeup call
-   	*/
-
-    lc.begin(dispPin,1,10000000);
-	lc.shutdown(0,false);
-  	lc.setIntensity(0,10);	// Set the brightness to a medium values 
-  	lc.clearDisplay(0);		// and clear the display
+	displayBegin(Config.displayCsPin);						// digits live before the sensor is found
+	sensorBegin(!resume && digitalRead(Config.buttonPin) == LOW);	// button held at power-on: calibrate
+	logBegin();
+	if (resume) resumeRound(cp);
+
+	schedAdd(taskSensor, SensorPeriod);
+	schedAdd(taskClock, ClockPeriod);
+	schedAdd(taskButton, ButtonPeriod);
+	schedAdd(taskDisplay, FrameInterval);
+	schedAdd(taskLog, LogPeriod);
+	schedAdd(taskCheckpoint, CheckpointPeriod);
+	buzzerBegin(Config.buzzerPin);
+	schedOnTick(clockTick);
+	schedOnTick(buzzerTick);
+	schedBegin();
+	watchdogBegin();						// after calibration, which takes seconds
 
 }
 
 void loop() {
-	
-	buzzer.loop(); // MUST call the buzzer.loop() function in loop()
-
-	if (shooting) {							// Push button etc. is diabled while on shot clock
-		if (remSecs == 0) {					// timer has expired
-			shooting = false;
-			soundIt(TIMESUP);
-			cdt.stop();
-			displayTimeout = millis();		// record current time to start display timeout
-		} else if (event) {					// hoop detected
-			scoreCount += 1;
-			soundIt(BASKET);
-			delay(200);					// allow time for ball to pass through without retriggering
-			event = false;
-			VL6180X.clearRangeInterrupt();
-		}
-		remSecs = cdt.remaining();			
-	} else {								// Push button enabled
-   		currentBtnState = digitalRead(BUTTON_PIN);
-		if (lastButtonState == HIGH && currentBtnState == LOW) {
-			remSecs	=	Fullcount;
-			preCount = remSecs;
-			scoreCount = 0;
-			lc.shutdown(0,false);			//  make shure display is awake
-			displayTimeout = millis();		//  renew display timer
-			cdt.start(0,0,0,Fullcount);		//  start countdown clock in secs	
-		} 
-		else if ((millis() - displayTimeout) > timeoutLimit) {
-			lc.shutdown(0, true);					// shutdown display after inactivity period
-		}
-		lastButtonState = currentBtnState;
-		if (cdt.isRunning() ) {						// clock has started
-			remSecs = cdt.remaining();
-			if (remSecs <= ShotClock) {
-				shooting = true;
-				event = false;
-				VL6180X.clearRangeInterrupt();
-			}
-			else if (preCount > remSecs){
-				soundIt(LAUNCHCOUNT);				// in pre-count phase
-				preCount = remSecs;
-			} 
-		}	
-	}
-
-	displayIt(SCOREDISP, scoreCount);
-	displayIt(CLOCKDISP, remSecs);
+	PROF_BEGIN(PROF_LOOP);
+	watchdogKick();
+	twiService();							// advance background I2C, run completions
+	tlmService();							// top up the Serial TX buffer
+	schedRun(twiIdle());					// run due tasks; idle only if the bus is quiet
+	PROF_END(PROF_LOOP);
 }
@@ -0,0 +1,424 @@
+/**********************************************************************************
+ *
+ *	Sensor  --  VL6180X hoop detector set-up and servicing
+ *
+ *  File:          Sensor.cpp
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#include 	<Arduino.h>
+#include 	<Wire.h>
+#include 	<DFRobot_VL6180X.h> //  ranging ToF sensor
+#include	"BallDetector.h"	//  ball-pass detection from range samples
+#include	"Calibration.h"		//  per-hoop thresholds stored in EEPROM
+#include	"TwiQueue.h"		//  background I2C for the per-basket / per-sample traffic
+#include	"Telemetry.h"		//  range samples, when built with TELEMETRY
+#include	"LatencyTrace.h"	//  clear completion, when built with LATENCY_TRACE
+#include	"Recovery.h"		//  watchdog, kicked through calibration
+#include	"Sensor.h"
+
+#define NoLane		0xFF
+#define AllReady	((1 << Lanes) - 1)
+
+static_assert(MaxLanes <= 4, "lane number is carried in the two low bits of a micros() stamp");
+
+DFRobot_VL6180X VL6180X[Lanes];			// all at VL6180X_ADDRESS until moved
+EventRing hoopEvents[Lanes];			// distance sensor triggered events, micros() stamped
+
+#if SensorMode == SENSOR_HIGHRATE
+static EventRing sampleReady[Lanes];	// sample-ready interrupts not yet read
+static RangeSample samples[Lanes][SampleBufSize];	// most recent samples, oldest overwritten
+static byte	sampleHead[Lanes];
+static BallDetector detector[Lanes];	// configured from each lane's calibration
+static byte serviceFirst = 0;			// lane served first by the next sensorService()
+#endif
+static byte rangeThreshold[Lanes];		// ball present below this range (mm)
+static byte ready = 0;					// bit per lane: VL6180X found and ranging
+static byte clearLost = 0;				// bit per lane: an interrupt clear failed, the sensor stays latched
+static bool calibrateOnStart = false;	// button was held at power-on
+static unsigned int retryDelay[Lanes];
+static uint32_t nextAttempt[Lanes];
+static byte booting = NoLane;			// lane just taken out of reset, waiting SensorBootMs
+static uint32_t bootDone = 0;
+static unsigned long sampleCount = 0;
+static uint32_t statsStart = 0;
+
+//	Bus address of a lane's sensor once brought up
+static inline byte laneAddress(byte lane) {
+	return Lanes == 1 ? VL6180X_ADDRESS : LaneAddress + lane;
+}
+
+//	micros() moves in 4 us steps on a 16 MHz part, so a read's tag carries the
+//	lane in the two low bits of its stamp
+static inline uint32_t laneTag(uint32_t stamp, byte lane) {
+	return Lanes == 1 ? stamp : (stamp & ~3UL) | lane;
+}
+
+//	A sensor interrupt on lane: a detection (window mode) or a new sample (high-rate)
+static inline void laneEvent(byte lane, uint32_t stamp) {
+#if SensorMode == SENSOR_HIGHRATE
+	sampleReady[lane].push(stamp);
+#else
+	hoopEvents[lane].push(stamp);
+#endif
+}
+
+//	ISR handler for ball detected through hoop (window mode) or new sample (high-rate)
+//  only counted if shooting == true
+void isr_scoreIt(){
+	laneEvent(0, micros());
+}
+
+#if Lanes > 1
+static byte laneLow = 0;				// bit per lane: INT line low at the last pin change
+
+//	Pin change on port C: every lane whose INT line has fallen since the last
+//	change gets an event; rising edges (the clears) only update laneLow
+static void laneChange() {
+	uint32_t stamp = micros();
+	for (byte lane = 1; lane < Lanes; lane++) {
+		byte mask = 1 << lane;
+		if (digitalRead(Config.laneIntPins[lane]) == HIGH) {
+			laneLow &= ~mask;
+		} else if (!(laneLow & mask)) {
+			laneLow |= mask;
+			laneEvent(lane, stamp);
+		}
+	}
+}
+
+#if defined(__AVR__)
+ISR(PCINT1_vect) {
+	laneChange();
+}
+
+static void laneAttach(byte pin) {
+	*digitalPinToPCMSK(pin) |= 1 << digitalPinToPCMSKbit(pin);
+	PCIFR = 1 << digitalPinToPCICRbit(pin);		// forget edges from before
+	PCICR |= 1 << digitalPinToPCICRbit(pin);
+}
+#else	// host build: the shims raise a virtual interrupt on either edge
+static void laneAttach(byte) {
+	attachInterrupt(NATIVE_PCINT1, laneChange, CHANGE);
+}
+#endif
+#endif
+
+//	Closest valid single-shot reading across the empty hoop, 255 if none.
+//	A lane found after boot calibrates from loop(), with the watchdog armed:
+//	the readings together run past WatchdogMs, so each one kicks it
+static byte sensorBaseline(byte lane) {
+	byte baseline = 255;
+	for (byte i = 0; i < CalSamples; i++) {
+		byte range = VL6180X[lane].rangePollMeasurement();
+		if (VL6180X[lane].getRangeResult() == VL6180X_NO_ERR && range < baseline)
+			baseline = range;
+		watchdogKick();
+	}
+	return baseline;
+}
+
+//	Set up a VL6180X that has just answered begin(): thresholds, interrupt
+//	mode and pin, then continuous ranging
+static void sensorConfigure(byte lane) {
+	Calibration cal;
+	DFRobot_VL6180X &sensor = VL6180X[lane];
+
+	if (calibrateOnStart) {						// empty hoop: measure and store new thresholds
+		cal.baseline = sensorBaseline(lane);
+		cal.threshold = calThreshold(cal.baseline);
+		calSave(cal, lane);
+		Serial.print(F("Calibrated: baseline "));
+		Serial.print(cal.baseline);
+		Serial.print(F(" mm, threshold "));
+		Serial.print(cal.threshold);
+		Serial.println(F(" mm"));
+	} else if (!calLoad(cal, lane)) {
+		cal.threshold = WindowLow;			// nothing stored yet: built-in default
+	}
+	rangeThreshold[lane] = cal.threshold;
+
+ 	 /** Enable the notification function of the INT pin
+ 	  * mode：
+ 	  * VL6180X_DIS_INTERRUPT          Not enable interrupt
+ 	  * VL6180X_LOW_INTERRUPT          Enable interrupt, by default the INT pin outputs low level
+  	 * VL6180X_HIGH_INTERRUPT         Enable interrupt, by default the INT pin outputs high level
+ 	  * Note: When using the VL6180X_LOW_INTERRUPT mode to enable the interrupt, please use "RISING" to trigger it.
+ 	  *       When using the VL6180X_HIGH_INTERRUPT mode to enable the interrupt, please use "FALLING" to trigger it.
+ 	  */
+ 	sensor.setInterrupt(/*mode*/VL6180X_HIGH_INTERRUPT); 
+
+  	/** Set the interrupt mode for collecting ambient light
+  	 * mode 
+  	 * interrupt disable  :                       VL6180X_INT_DISABLE             0
+  	 * value < thresh_low :                       VL6180X_LEVEL_LOW               1 
+  	 * value > thresh_high:                       VL6180X_LEVEL_HIGH              2
+  	 * value < thresh_low OR value > thresh_high: VL6180X_OUT_OF_WINDOW           3
+  	 * new sample ready   :                       VL6180X_NEW_SAMPLE_READY        4
+  	 */
+#if SensorMode == SENSOR_HIGHRATE
+	detector[lane].configure(DetectorConfig{ rangeThreshold[lane], (byte)(rangeThreshold[lane] + BallHysteresis), BallConfirm });
+  	sensor.rangeConfigInterrupt(VL6180X_NEW_SAMPLE_READY);
+  	sensor.rangeSetInterMeasurementPeriod(/* periodMs 0-25500ms */HighRatePeriod);
+#else
+  	sensor.rangeConfigInterrupt(VL6180X_OUT_OF_WINDOW);
+
+  	/*Set the range measurement period*/
+  	sensor.rangeSetInterMeasurementPeriod(/* periodMs 0-25500ms */WindowPeriod);
+
+  	/*Set threshold value*/
+  	sensor.setRangeThresholdValue(/*thresholdL 0-255mm */rangeThreshold[lane],/*thresholdH 0-255mm*/WindowHigh);
+#endif
+
+  	#if defined(ESP32) || defined(ESP8266)||defined(ARDUINO_SAM_ZERO)
+  	attachInterrupt(digitalPinToInterrupt(D9)/*Query the interrupt number of the D9 pin*/,interrupt,FALLING);
+  	#else
+ 	 /*    The Correspondence Table of AVR Series Arduino Interrupt Pins And Terminal Numbers
+  	 * ---------------------------------------------------------------------------------------
+  	 * |                                        |  DigitalPin  | 2  | 3  |                   |
+  	 * |    Uno, Nano, Mini, other 328-based    |--------------------------------------------|
+  	 * |                                        | Interrupt No | 0  | 1  |                   |
+ 	 * |-------------------------------------------------------------------------------------|
+   	* |                                        |    Pin       | 2  | 3  | 21 | 20 | 19 | 18 |
+   	* |               Mega2560                 |--------------------------------------------|
+   	* |                                        | Interrupt No | 0  | 1  | 2  | 3  | 4  | 5  |
+   	* |-------------------------------------------------------------------------------------|
+   	* |                                        |    Pin       | 3  | 2  | 0  | 1  | 7  |    |
+   	* |    Leonardo, other 32u4-based          |--------------------------------------------|
+   	* |                                        | Interrupt No | 0  | 1  | 2  | 3  | 4  |    |
+   	* |--------------------------------------------------------------------------------------
+   */
+  
+	if (lane == 0)
+  		attachInterrupt(/*Interrupt No*/1,isr_scoreIt,FALLING);	//Enable the external interrupt 1, connect INT1/2 to the digital pin of the main control: 
+    	//UNO(2), Mega2560(2), Leonardo(3), microbit(P0).
+#if Lanes > 1
+	else {
+		if (digitalRead(Config.laneIntPins[lane]) == LOW) laneLow |= 1 << lane;
+		laneAttach(Config.laneIntPins[lane]);
+	}
+#endif
+  	#endif
+
+  	/*Start continuous range measuring mode */
+  	sensor.rangeStartContinuousMode();
+	sensorResetStats();
+}
+
+//	Completion of an interrupt clear; a lost one is sent again by sensorPoll()
+static void clearDone(byte status, const byte *, uint32_t lane) {
+	if (status != TWI_OK) clearLost |= 1 << lane;
+	else if (lane == 0) TRACE_MARK(TRACE_BASKET, TRACE_CLEAR);
+}
+
+static void postClear(byte lane) {
+	while (!twiWriteReg(laneAddress(lane), SYSTEM__INTERRUPT_CLEAR, ClearRangeInt, clearDone, lane))
+		twiService();							// queue full: the clear must not be lost
+}
+
+void sensorBegin(bool calibrate) {
+	calibrateOnStart = calibrate;
+	ready = 0;
+	clearLost = 0;
+	booting = NoLane;
+	for (byte lane = 0; lane < Lanes; lane++) {
+#if Lanes > 1
+		pinMode(Config.laneCePins[lane], OUTPUT);
+		digitalWrite(Config.laneCePins[lane], LOW);	// all in reset: none may answer at 0x29 yet
+#endif
+		retryDelay[lane] = SensorRetryMin;
+		nextAttempt[lane] = millis();
+	}
+	sensorPoll();							// a healthy sensor is ready straight away
+}
+
+//	A blocking Wire call that ran into WireTimeout left the bus hung: clear it
+static bool wireHung() {
+	if (!Wire.getWireTimeoutFlag()) return false;
+	Wire.clearWireTimeoutFlag();
+	twiBusClear();
+	return true;
+}
+
+//	One begin() attempt on a lane whose sensor should now be at VL6180X_ADDRESS;
+//	a set-up cut short by a hung bus is retried like a missing sensor
+static void sensorAttempt(byte lane) {
+	bool found = VL6180X[lane].begin();
+	if (found) {
+#if Lanes > 1
+		VL6180X[lane].setIICAddr(laneAddress(lane));	// off the default before the next lane boots
+#endif
+		sensorConfigure(lane);
+	}
+	if (!wireHung() && found) {
+		ready |= 1 << lane;
+		Serial.print(F("Sensor "));
+		if (Lanes > 1) {
+			Serial.print(lane + 1);
+			Serial.print(' ');
+		}
+		Serial.println(F("ready"));
+		return;
+	}
+#if Lanes > 1
+	//	Reset brings the part back at VL6180X_ADDRESS, but a driver that moved
+	//	it keeps laneAddress(): a fresh one looks where the next begin() must
+	VL6180X[lane] = DFRobot_VL6180X();
+	digitalWrite(Config.laneCePins[lane], LOW);		// back into reset, off the bus
+#endif
+	if (retryDelay[lane] == SensorRetryMin)
+    	Serial.println(F("Please check that the IIC device is properly connected!"));
+	nextAttempt[lane] = millis() + retryDelay[lane];
+	retryDelay[lane] = (retryDelay[lane] >= SensorRetryMax / 2) ? SensorRetryMax : retryDelay[lane] * 2;
+}
+
+//	One begin() attempt when due; retries back off from SensorRetryMin to
+//	SensorRetryMax so a missing sensor costs almost nothing per loop().  With
+//	several lanes a sensor is first taken out of reset and given SensorBootMs,
+//	one lane at a time
+void sensorPoll() {
+	for (byte lane = 0; lane < Lanes; lane++) {
+		if ((clearLost & (1 << lane)) && twiIdle()) {
+			clearLost &= ~(1 << lane);			// until this one fails too
+			postClear(lane);
+		}
+	}
+	if (ready == AllReady || !twiIdle()) return;
+
+	if (booting != NoLane) {
+		if ((int32_t)(millis() - bootDone) < 0) return;
+		byte lane = booting;
+		booting = NoLane;
+		sensorAttempt(lane);
+		return;
+	}
+	for (byte lane = 0; lane < Lanes; lane++) {
+		if ((ready & (1 << lane)) || (int32_t)(millis() - nextAttempt[lane]) < 0) continue;
+#if Lanes > 1
+		digitalWrite(Config.laneCePins[lane], HIGH);	// boots at VL6180X_ADDRESS
+		booting = lane;
+		bootDone = millis() + SensorBootMs;
+#else
+		sensorAttempt(lane);
+#endif
+		return;
+	}
+}
+
+bool sensorReady() {
+	return ready != 0;
+}
+
+bool sensorReady(byte lane) {
+	return (ready & (1 << lane)) != 0;
+}
+
+#if SensorMode == SENSOR_HIGHRATE
+//	Completion of a posted range read: store the sample and feed the detector
+static void sampleRead(byte status, const byte *data, uint32_t tag) {
+	if (status != TWI_OK) return;
+	byte lane = Lanes == 1 ? 0 : tag & 3;
+	uint32_t stamp = Lanes == 1 ? tag : tag & ~3UL;
+	RangeSample &s = samples[lane][sampleHead[lane]];
+
+	// after a gap (failed reads, a sleep) the samples either side are not one
+	// pass: without this a stale entry time would be stamped on the next ball
+	if (stamp - samples[lane][(sampleHead[lane] - 1) & (SampleBufSize - 1)].stamp > SampleGapMs * 1000UL)
+		detector[lane].reset();
+	s.stamp = stamp;
+	s.range = data[0];
+	sampleHead[lane] = (sampleHead[lane] + 1) & (SampleBufSize - 1);
+	sampleCount++;
+	if (lane == 0) tlmRange(stamp, data[0], VL6180X_NO_ERR);
+
+	if (detector[lane].feed(stamp, data[0], VL6180X_NO_ERR))
+		hoopEvents[lane].push(detector[lane].entryTime());
+}
+#endif
+
+//	Post a read of each sample signalled since the last pass, then the clear
+//	that lets the sensor raise the next one; both complete in the background.
+//	Lanes take turns, one sample each per round, starting one lane further on
+//	each call so no lane is always last; samples the queue has no room for
+//	wait in their ring for the next call.  A pass is stamped with the time of
+//	its first sample below the threshold.  The status register is not read,
+//	to keep to two I2C transactions a sample
+void sensorService() {
+#if SensorMode == SENSOR_HIGHRATE
+	uint32_t stamp;
+	bool more = true;
+
+	while (more) {
+		more = false;
+		for (byte n = 0, lane = serviceFirst; n < Lanes; n++, lane = (lane + 1 == Lanes) ? 0 : lane + 1) {
+			if (twiFree() < 2) break;
+			if (!sampleReady[lane].pop(stamp)) continue;
+			twiReadReg(laneAddress(lane), RESULT__RANGE_VAL, 1, sampleRead, laneTag(stamp, lane));
+			postClear(lane);
+			more = true;
+		}
+	}
+	serviceFirst = (serviceFirst + 1 == Lanes) ? 0 : serviceFirst + 1;
+#endif
+}
+
+void sensorRearm(byte lane) {
+#if SensorMode == SENSOR_WINDOW
+	for (byte l = 0; l < Lanes; l++)			// out-of-window interrupt latches until cleared
+		if ((lane == AllLanes || l == lane) && sensorReady(l)) postClear(l);
+#else
+	(void)lane;
+#endif
+}
+
+void sensorFlush() {
+	for (byte lane = 0; lane < Lanes; lane++) {
+		hoopEvents[lane].flush();
+		hoopEvents[lane].clearDropped();
+	}
+}
+
+byte sensorDropped() {
+	unsigned int dropped = 0;
+	for (byte lane = 0; lane < Lanes; lane++)
+		dropped += hoopEvents[lane].dropped();
+	return dropped > 0xFF ? 0xFF : dropped;
+}
+
+//	Ranging stops so the sensors draw only their standby current while the MCU
+//	is powered down; both wait for the bus so the order around sleep is certain
+void sensorStandby() {
+	for (byte lane = 0; lane < Lanes; lane++) {
+		if (!sensorReady(lane)) continue;
+		twiWriteReg(laneAddress(lane), SYSRANGE__START, RangeStartStop);
+		twiFlush();
+	}
+}
+
+void sensorResume() {
+	for (byte lane = 0; lane < Lanes; lane++) {
+		if (!sensorReady(lane)) continue;
+		twiWriteReg(laneAddress(lane), SYSTEM__INTERRUPT_CLEAR, ClearRangeInt, clearDone, lane);
+		twiWriteReg(laneAddress(lane), SYSRANGE__START, RangeContinuous);
+		twiFlush();								// the queue holds two lanes' worth at most
+	}
+}
+
+byte sensorThreshold(byte lane) {
+	return rangeThreshold[lane];
+}
+
+void sensorResetStats() {
+	sampleCount = 0;
+	statsStart = millis();
+}
+
+unsigned int sensorSampleRate() {
+	uint32_t elapsed = millis() - statsStart;
+	return elapsed ? (unsigned int)(sampleCount * 1000UL / elapsed) : 0;
+}
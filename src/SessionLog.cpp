@@ -0,0 +1,167 @@
+/**********************************************************************************
+ *
+ *	SessionLog  --  per-round history in an EEPROM ring
+ *
+ *  File:          SessionLog.cpp
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#include	<Arduino.h>
+#include	<EEPROM.h>
+#include	"Calibration.h"			//  crc16(), and the record the log must not overlap
+#include	"Config.h"				//  precount the write must finish within
+#include	"GameMode.h"
+#include	"SessionLog.h"
+
+#if defined(__AVR__)
+#include	<avr/eeprom.h>
+#endif
+
+static_assert(sizeof(LogRecord) <= LogSlotSize, "record does not fit a slot");
+static_assert(LogAddress >= CalAddress + sizeof(Calibration), "log overlaps the calibration");
+static_assert(LogAddress + LogSlots * LogSlotSize <= 1024, "log runs past the ATmega328 EEPROM");
+static_assert(CalLaneAddress >= LogAddress + LogSlots * LogSlotSize, "log overlaps the lane calibration");
+static_assert(MODE_COUNT <= LogModes, "no high score slot for every game mode");
+//	a closed round is written while the next one counts in, ~4 ms a byte
+static_assert(Config.precountSecs * 1000UL > LogSlotSize * 4UL, "a round's record must be written within the precount");
+
+#define LogHeadBytes	10			// seq .. result, covered by the crc with the shots
+
+static LogRecord rec;				// round being gathered
+static LogRecord out;				// last round closed, being written
+static byte nextSlot = 0;
+static uint16_t nextSeq = 0;
+static uint16_t highs[LogModes];
+static int writePos = -1;			// byte of out being written, -1 = nothing pending
+static int dumpLeft = 0;			// slots still to stream
+static byte dumpSlot;
+
+static inline int slotAddress(byte slot) {
+	return LogAddress + slot * LogSlotSize;
+}
+
+static inline byte recordBytes(const LogRecord &r) {
+	return LogHeadBytes + sizeof(uint16_t) + r.shots * sizeof(uint16_t);
+}
+
+static uint16_t recordCrc(const LogRecord &r) {
+	uint16_t crc = crc16((const byte *)&r, LogHeadBytes);
+	return crc16((const byte *)r.shot, r.shots * sizeof(uint16_t), crc);
+}
+
+//	Read a slot into r; false if it has never held a whole record
+static bool readSlot(byte slot, LogRecord &r) {
+	EEPROM.get(slotAddress(slot), r);
+	return r.shots <= LogMaxShots && r.mode < LogModes && r.crc == recordCrc(r);
+}
+
+void logBegin() {
+	bool found = false;
+	uint16_t newest = 0;
+
+	memset(highs, 0, sizeof(highs));
+	nextSlot = 0;
+	nextSeq = 0;
+	for (byte slot = 0; slot < LogSlots; slot++) {
+		if (!readSlot(slot, rec)) continue;
+		if (modeBeats(rec.mode, rec.high, highs[rec.mode])) highs[rec.mode] = rec.high;
+		if (!found || (int16_t)(rec.seq - newest) > 0) {
+			found = true;
+			newest = rec.seq;
+			nextSlot = (slot + 1) % LogSlots;
+			nextSeq = rec.seq + 1;
+		}
+	}
+	logNewRound();
+}
+
+void logNewRound() {
+	rec.shots = 0;					// the last round, if still being written, has its own copy
+}
+
+void logShot(unsigned long sinceStartUs) {
+	if (rec.shots < LogMaxShots)
+		rec.shot[rec.shots++] = sinceStartUs / 10000UL;
+}
+
+void logRound(byte mode, int baskets, int result) {
+	rec.seq = nextSeq++;
+	rec.mode = mode < LogModes ? mode : 0;
+	rec.baskets = baskets;
+	rec.result = result;
+	if (modeBeats(rec.mode, rec.result, highs[rec.mode])) highs[rec.mode] = rec.result;
+	rec.high = highs[rec.mode];
+	rec.crc = recordCrc(rec);
+	out = rec;
+	writePos = 0;
+}
+
+//	Write the next byte that differs; power lost part way leaves a slot that
+//	fails its crc, and the previous rounds are untouched
+static void writeStep() {
+	int addr = slotAddress(nextSlot);
+	byte len = recordBytes(out);
+
+#if defined(__AVR__)
+	if (!eeprom_is_ready()) return;			// previous byte still programming (3.3 ms)
+#endif
+	while (writePos < len) {
+		byte b = ((const byte *)&out)[writePos];
+		int at = addr + writePos++;
+		if (EEPROM.read(at) != b) {
+			EEPROM.write(at, b);
+			return;							// one write per call
+		}
+	}
+	writePos = -1;
+	nextSlot = (nextSlot + 1) % LogSlots;
+}
+
+static void printRecord(const LogRecord &r) {
+	Serial.print(r.seq);
+	Serial.print(',');
+	Serial.print(r.mode);
+	Serial.print(',');
+	Serial.print(r.baskets);
+	Serial.print(',');
+	Serial.print(r.result);
+	Serial.print(',');
+	Serial.print(r.high);
+	for (byte i = 0; i < r.shots; i++) {
+		Serial.print(',');
+		Serial.print(r.shot[i] * 10UL);
+	}
+	Serial.println();
+}
+
+static void dumpStep() {
+	LogRecord r;
+
+	if (readSlot(dumpSlot, r)) printRecord(r);
+	dumpSlot = (dumpSlot + 1) % LogSlots;
+	if (--dumpLeft == 0) Serial.println(F("end"));
+}
+
+void logService() {
+	if (writePos >= 0) writeStep();
+	else if (dumpLeft > 0) dumpStep();
+}
+
+void logDump() {
+	Serial.println(F("seq,mode,baskets,result,high,shots ms"));
+	dumpSlot = nextSlot;					// oldest first; empty slots are skipped
+	dumpLeft = LogSlots;
+}
+
+uint16_t logHighScore(byte mode) {
+	return mode < LogModes ? highs[mode] : 0;
+}
+
+uint16_t logRounds() {
+	return nextSeq;
+}
@@ -0,0 +1,103 @@
+/**********************************************************************************
+ *
+ *	Telemetry  --  framed binary records over Serial without blocking
+ *
+ *  File:          Telemetry.cpp
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#include	<Arduino.h>
+#include	"Calibration.h"			//  crc16()
+#include	"Sensor.h"				//  detection drops
+#include	"TwiQueue.h"
+#include	"Scheduler.h"
+#include	"Telemetry.h"
+
+#ifdef TELEMETRY
+
+static_assert((TlmBufSize & (TlmBufSize - 1)) == 0, "TlmBufSize must be a power of 2");
+
+static byte buf[TlmBufSize];
+static byte head = 0, tail = 0;			// loop() side only: no ISR sends
+static byte seq = 0;
+static unsigned int dropped = 0;
+static uint32_t lastLoopStats = 0;
+
+//	Finish a record whose body is already in rec[2..], frame it and queue it whole
+static void send(byte type, byte *rec) {
+	byte len = TlmHeadSize + tlmBodySize(type);
+	byte frame[TlmMaxFrame];
+	byte n;
+
+	rec[0] = type;
+	rec[1] = seq;
+	tlmPut16(rec + len, crc16(rec, len));
+	frame[0] = 0;
+	n = 1 + cobsEncode(rec, len + TlmCrcSize, frame + 1);
+	frame[n++] = 0;
+
+	if (((tail - head - 1) & (TlmBufSize - 1)) < n) {
+		if (dropped != 0xFFFF) dropped++;
+		return;
+	}
+	seq++;								// only sent records advance, so gaps mean loss
+	for (byte i = 0; i < n; i++) {
+		buf[head] = frame[i];
+		head = (head + 1) & (TlmBufSize - 1);
+	}
+}
+
+void tlmState(byte state, byte mode, unsigned int remMs) {
+	byte rec[TlmMaxRecord];
+	tlmPut32(rec + 2, micros());
+	rec[6] = state;
+	rec[7] = mode;
+	tlmPut16(rec + 8, remMs);
+	send(TlmState, rec);
+}
+
+void tlmShot(uint32_t stamp, int baskets, int score) {
+	byte rec[TlmMaxRecord];
+	tlmPut32(rec + 2, stamp);
+	tlmPut16(rec + 6, baskets);
+	tlmPut16(rec + 8, score);
+	send(TlmShot, rec);
+}
+
+void tlmRange(uint32_t stamp, byte range, byte status) {
+	byte rec[TlmMaxRecord];
+	tlmPut32(rec + 2, stamp);
+	rec[6] = range;
+	rec[7] = status;
+	send(TlmRange, rec);
+}
+
+static void tlmLoop() {
+	byte rec[TlmMaxRecord];
+	tlmPut32(rec + 2, micros());
+	tlmPut16(rec + 6, schedMisses());
+	tlmPut16(rec + 8, schedMaxLate());
+	rec[10] = sensorDropped();
+	rec[11] = twiTimeouts();
+	tlmPut16(rec + 12, dropped);
+	send(TlmLoop, rec);
+}
+
+void tlmService() {
+	if (millis() - lastLoopStats >= TlmLoopPeriod) {
+		lastLoopStats = millis();
+		tlmLoop();
+	}
+	int room = Serial.availableForWrite();
+	while (room-- > 0 && tail != head) {
+		Serial.write(buf[tail]);
+		tail = (tail + 1) & (TlmBufSize - 1);
+	}
+}
+
+#endif
@@ -0,0 +1,237 @@
+/**********************************************************************************
+ *
+ *	TwiQueue  --  non-blocking queue of I2C register transactions
+ *
+ *  File:          TwiQueue.cpp
+ *
+ *  Copyright:     Copyright (c) 2024 Kevin Barrell
+ *
+ *  License:       MIT License. See accompanying LICENSE file.
+ *
+ *  Author:        Kevin Barrell
+ * ********************************************************************************
+*/
+#include	<Arduino.h>
+#include	"TwiQueue.h"
+#include	"Recovery.h"		//  every bus clear is counted as a fault
+
+#if defined(__AVR__)
+#include	<util/twi.h>
+#endif
+
+struct TwiTransaction {
+	byte			addr;
+	byte			tx[2 + TwiMaxData];		// register address, then any data to write
+	byte			txLen;
+	byte			rx[TwiMaxData];
+	byte			rxLen;
+	TwiCallback		callback;
+	uint32_t		tag;
+};
+
+static TwiTransaction queue[TwiQueueSize];
+static byte head = 0;					// next free slot
+static byte tail = 0;					// transaction in progress, or next to start
+static bool active = false;
+static byte timeouts = 0;
+
+static bool post(byte addr, uint16_t reg, const byte *data, byte txData, byte rxLen,
+				 TwiCallback cb, uint32_t tag) {
+	byte next = (head + 1) & (TwiQueueSize - 1);
+	if (next == tail || txData > TwiMaxData || rxLen > TwiMaxData) return false;
+
+	TwiTransaction &t = queue[head];
+	t.addr = addr;
+	t.tx[0] = reg >> 8;
+	t.tx[1] = reg & 0xFF;
+	for (byte i = 0; i < txData; i++) t.tx[2 + i] = data[i];
+	t.txLen = 2 + txData;
+	t.rxLen = rxLen;
+	t.callback = cb;
+	t.tag = tag;
+	head = next;
+	return true;
+}
+
+bool twiWriteReg(byte addr, uint16_t reg, byte value, TwiCallback cb, uint32_t tag) {
+	return post(addr, reg, &value, 1, 0, cb, tag);
+}
+
+bool twiReadReg(byte addr, uint16_t reg, byte len, TwiCallback cb, uint32_t tag) {
+	return post(addr, reg, 0, 0, len, cb, tag);
+}
+
+bool twiIdle() {
+	return !active && head == tail;
+}
+
+byte twiFree() {
+	return (tail - head - 1) & (TwiQueueSize - 1);
+}
+
+//	Only for the rare places that must wait (entering / leaving sleep); bounded
+//	because every transaction either completes or times out
+bool twiFlush() {
+	byte before = timeouts;
+	while (!twiIdle())
+		twiService();
+	return timeouts == before;
+}
+
+byte twiTimeouts() {
+	return timeouts;
+}
+
+//	Retire the transaction at tail, then tell its owner; the callback may post more
+static void finish(byte status) {
+	TwiTransaction &t = queue[tail];
+	TwiCallback cb = t.callback;
+	byte data[TwiMaxData];
+	uint32_t tag = t.tag;
+
+	memcpy(data, t.rx, sizeof(data));
+	active = false;
+	tail = (tail + 1) & (TwiQueueSize - 1);
+	if (status == TWI_TIMEOUT && timeouts != 0xFF) timeouts++;
+	if (cb) cb(status, data, tag);
+}
+
+#if defined(__AVR__)
+
+#define TWI_WRITING	0
+#define TWI_READING	1
+
+static byte phase;
+static byte txPos, rxPos;
+static uint32_t lastStep;
+
+static inline void twiStart()		{ TWCR = _BV(TWINT) | _BV(TWSTA) | _BV(TWEN); }
+static inline void twiStop()		{ TWCR = _BV(TWINT) | _BV(TWSTO) | _BV(TWEN); }
+static inline void twiSend(byte b)	{ TWDR = b; TWCR = _BV(TWINT) | _BV(TWEN); }
+static inline void twiAck(bool ack)	{ TWCR = _BV(TWINT) | _BV(TWEN) | (ack ? _BV(TWEA) : 0); }
+
+//	One step of the master transmitter / receiver, after TWINT has been set
+static void step() {
+	TwiTransaction &t = queue[tail];
+
+	switch (TW_STATUS) {
+		case TW_START:
+		case TW_REP_START:
+			twiSend((t.addr << 1) | (phase == TWI_READING ? TW_READ : TW_WRITE));
+			break;
+		case TW_MT_SLA_ACK:
+		case TW_MT_DATA_ACK:
+			if (txPos < t.txLen) {
+				twiSend(t.tx[txPos++]);
+			} else if (t.rxLen) {
+				phase = TWI_READING;				// repeated start to read the register
+				twiStart();
+			} else {
+				twiStop();
+				finish(TWI_OK);
+			}
+			break;
+		case TW_MR_SLA_ACK:
+			twiAck(t.rxLen > 1);
+			break;
+		case TW_MR_DATA_ACK:
+			t.rx[rxPos++] = TWDR;
+			twiAck(rxPos < t.rxLen - 1);
+			break;
+		case TW_MR_DATA_NACK:
+			t.rx[rxPos++] = TWDR;
+			twiStop();
+			finish(TWI_OK);
+			break;
+		case TW_MT_SLA_NACK:
+		case TW_MT_DATA_NACK:
+		case TW_MR_SLA_NACK:
+			twiStop();
+			finish(TWI_NACK);
+			break;
+		case TW_MT_ARB_LOST:
+			TWCR = _BV(TWINT) | _BV(TWEN);			// release the bus
+			finish(TWI_ERROR);
+			break;
+		default:									// bus error
+			twiStop();
+			finish(TWI_ERROR);
+			break;
+	}
+}
+
+void twiService() {
+	if (active) {
+		if (TWCR & _BV(TWINT)) {
+			lastStep = micros();
+			step();
+		} else if ((micros() - lastStep) > TwiTimeout) {
+			twiBusClear();							// drop the transfer, free the bus, fresh TWI unit
+			finish(TWI_TIMEOUT);
+		}
+	}
+	if (!active && head != tail && !(TWCR & _BV(TWSTO))) {	// previous STOP has gone out
+		phase = TWI_WRITING;
+		txPos = rxPos = 0;
+		active = true;
+		lastStep = micros();
+		twiStart();
+	}
+}
+
+#define BitUs	5							// half an SCL period by hand: 100 kHz
+
+//	The TWI unit is off while the pins are worked; each line is released to its
+//	pull-up (input) or pulled low (output, port bit 0), as open drain
+static inline void line(byte pin, bool high) {
+	pinMode(pin, high ? INPUT : OUTPUT);
+	delayMicroseconds(BitUs);
+}
+
+bool twiBusClear() {
+	TWCR = 0;
+	digitalWrite(SDA, LOW);						// port bits low, internal pull-ups off
+	digitalWrite(SCL, LOW);
+	line(SDA, true);
+	line(SCL, true);
+	for (byte i = 0; i < 9 && digitalRead(SDA) == LOW; i++) {
+		line(SCL, false);						// the slave shifts out its next bit
+		line(SCL, true);
+	}
+	line(SCL, false);							// STOP: SDA rises while SCL is high
+	line(SDA, false);
+	line(SCL, true);
+	line(SDA, true);
+	bool freed = digitalRead(SDA) == HIGH;
+
+	digitalWrite(SDA, HIGH);					// pull-ups back on, as Wire leaves them
+	digitalWrite(SCL, HIGH);
+	TWCR = _BV(TWEN);
+	faultNote(FaultBus);
+	return freed;
+}
+
+#else	// host build: the shims complete one whole transaction per twiService()
+
+#include	"NativeHost.h"
+
+//	A stuck bus shows as a transfer that gets nowhere; the AVR build would time out
+void twiService() {
+	if (head == tail) return;
+	TwiTransaction &t = queue[tail];
+	active = true;
+	if (native::sdaHeld()) {
+		twiBusClear();
+		finish(TWI_TIMEOUT);
+		return;
+	}
+	bool ack = native::twiTransfer(t.addr, t.tx, t.txLen, t.rx, t.rxLen);
+	finish(ack ? TWI_OK : TWI_NACK);
+}
+
+bool twiBusClear() {
+	faultNote(FaultBus);
+	return native::busClear();
+}
+
+#endif
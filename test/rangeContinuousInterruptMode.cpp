@@ -113,11 +113,12 @@ void loop() {
       /*Clear interrupts generated by measuring range*/
       VL6180X.clearRangeInterrupt();
       flag = 0;
-      String str1 = "Range: "+String(count) + " mm"; 
-      Serial.println(str1);
+      Serial.print(F("Range: "));     // no String: nothing allocated per event
+      Serial.print(count);
+      Serial.println(F(" mm"));
     /*  switch(status){
         case VL6180X_NO_ERR:
-          Serial.println(str1);
+          Serial.println(range);
           break;
         case VL6180X_EARLY_CONV_ERR:
           Serial.println("RANGE ERR: ECE check failed !");